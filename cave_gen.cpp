@@ -0,0 +1,172 @@
+#include "cave_gen.hpp"
+#include "tile.hpp"
+
+// ------- BitGrid -------
+
+BitGrid::BitGrid(int width, int height)
+    : width_(width), height_(height), words_((width + 63) / 64) {
+    int tail = width & 63;
+    lastMask_ = tail == 0 ? ~0ull : ((1ull << tail) - 1);
+    bits_.assign(static_cast<std::size_t>(words_) * height, ~0ull);
+}
+
+void BitGrid::set(int x, int y, bool v) {
+    std::uint64_t& w = bits_[static_cast<std::size_t>(y) * words_ + (x >> 6)];
+    std::uint64_t bit = 1ull << (x & 63);
+    if (v) w |= bit;
+    else   w &= ~bit;
+}
+
+// ------- 随机数：splitmix64，每行独立播种，并行填充结果也确定 -------
+
+static std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// 每次用一个随机字节和阈值比较，生成 64 个独立的“是否为墙”位
+static std::uint64_t random_wall_word(std::uint64_t& state, unsigned threshold) {
+    std::uint64_t word = 0;
+    for (int chunk = 0; chunk < 8; ++chunk) {
+        std::uint64_t r = splitmix64(state);
+        for (int b = 0; b < 8; ++b) {
+            unsigned byte = static_cast<unsigned>((r >> (b * 8)) & 0xff);
+            if (byte < threshold) word |= 1ull << (chunk * 8 + b);
+        }
+    }
+    return word;
+}
+
+// 四周一圈强制为墙，填充位也置 1
+static void seal_row(BitGrid& g, int y) {
+    std::uint64_t* row = g.row(y);
+    int words = g.wordsPerRow();
+
+    if (y == 0 || y == g.height() - 1) {
+        for (int w = 0; w < words; ++w) row[w] = ~0ull;
+        return;
+    }
+
+    row[0] |= 1ull;
+    int last = g.width() - 1;
+    row[last >> 6] |= 1ull << (last & 63);
+    row[words - 1] |= ~g.lastWordMask();
+}
+
+// ------- 位并行邻居计数 -------
+
+// 三个 1 位输入相加：和位 + 进位
+static inline void full_add(std::uint64_t a, std::uint64_t b, std::uint64_t c,
+                            std::uint64_t& sum, std::uint64_t& carry) {
+    std::uint64_t t = a ^ b;
+    sum   = t ^ c;
+    carry = (a & b) | (t & c);
+}
+
+// 根据上一行、本行、下一行算出本行的新状态（64 格一组）
+static void step_row(const std::uint64_t* up, const std::uint64_t* mid, const std::uint64_t* down,
+                     std::uint64_t* out, int words) {
+    for (int w = 0; w < words; ++w) {
+        // 越界的字当作全墙
+        std::uint64_t upL   = w > 0         ? up[w - 1]   : ~0ull;
+        std::uint64_t upR   = w + 1 < words ? up[w + 1]   : ~0ull;
+        std::uint64_t midL  = w > 0         ? mid[w - 1]  : ~0ull;
+        std::uint64_t midR  = w + 1 < words ? mid[w + 1]  : ~0ull;
+        std::uint64_t downL = w > 0         ? down[w - 1] : ~0ull;
+        std::uint64_t downR = w + 1 < words ? down[w + 1] : ~0ull;
+
+        // 第 x 位放 x-1 / x+1 处的值
+        auto west = [](std::uint64_t cur, std::uint64_t left)  { return (cur << 1) | (left >> 63); };
+        auto east = [](std::uint64_t cur, std::uint64_t right) { return (cur >> 1) | (right << 63); };
+
+        std::uint64_t n[8] = {
+            west(up[w], upL),     up[w],   east(up[w], upR),
+            west(mid[w], midL),            east(mid[w], midR),
+            west(down[w], downL), down[w], east(down[w], downR)
+        };
+
+        // 8 个 1 位数相加得到 4 位计数 b3 b2 b1 b0（0~8）
+        std::uint64_t s0, c0, s1, c1;
+        full_add(n[0], n[1], n[2], s0, c0);
+        full_add(n[3], n[4], n[5], s1, c1);
+        std::uint64_t s2 = n[6] ^ n[7];
+        std::uint64_t c2 = n[6] & n[7];
+
+        std::uint64_t b0, k;          // 个位与进到 2 的位
+        full_add(s0, s1, s2, b0, k);
+        std::uint64_t t0, t1;         // 2 位上的和与进到 4 的位
+        full_add(c0, c1, c2, t0, t1);
+        std::uint64_t b1 = t0 ^ k;
+        std::uint64_t u  = t0 & k;
+        std::uint64_t b2 = t1 ^ u;
+        std::uint64_t b3 = t1 & u;
+
+        // >= 5 变墙；原来是墙且 >= 4 保持
+        out[w] = b3 | (b2 & (b1 | b0 | mid[w]));
+    }
+}
+
+// ------- 生成 -------
+
+BitGrid generate_cave_bits(const CaveParams& params, WorkStealingPool* pool) {
+    int width  = params.width;
+    int height = params.height;
+
+    BitGrid cur(width, height);
+    BitGrid next(width, height);
+    if (width < 3 || height < 3) return cur;
+
+    int words = cur.wordsPerRow();
+    unsigned threshold = static_cast<unsigned>(params.fillPercent * 256 / 100);
+
+    // 行块大小：一块大约 64K 个格子，任务不会太碎
+    std::size_t grain = static_cast<std::size_t>(65536 / width + 1);
+
+    auto for_rows = [&](const std::function<void(std::size_t, std::size_t)>& body) {
+        if (pool) pool->parallel_for(static_cast<std::size_t>(height), grain, body);
+        else      body(0, static_cast<std::size_t>(height));
+    };
+
+    // 1. 随机填充
+    for_rows([&](std::size_t begin, std::size_t end) {
+        for (std::size_t y = begin; y < end; ++y) {
+            std::uint64_t state = (static_cast<std::uint64_t>(params.seed) << 32) ^ (y * 0xd1b54a32d192ed03ull);
+            std::uint64_t* row = cur.row(static_cast<int>(y));
+            for (int w = 0; w < words; ++w) {
+                row[w] = random_wall_word(state, threshold);
+            }
+            seal_row(cur, static_cast<int>(y));
+        }
+    });
+
+    // 2. 细胞自动机平滑，双缓冲
+    std::vector<std::uint64_t> solid(words, ~0ull); // 地图外的一整行墙
+    for (int it = 0; it < params.iterations; ++it) {
+        for_rows([&](std::size_t begin, std::size_t end) {
+            for (std::size_t yy = begin; yy < end; ++yy) {
+                int y = static_cast<int>(yy);
+                const std::uint64_t* up   = y > 0          ? cur.row(y - 1) : solid.data();
+                const std::uint64_t* down = y + 1 < height ? cur.row(y + 1) : solid.data();
+                step_row(up, cur.row(y), down, next.row(y), words);
+                seal_row(next, y);
+            }
+        });
+        std::swap(cur, next);
+    }
+
+    return cur;
+}
+
+std::vector<std::string> cave_to_map(const BitGrid& grid) {
+    std::vector<std::string> map(grid.height(), std::string(grid.width(), TILE_WALL));
+    for (int y = 0; y < grid.height(); ++y) {
+        const std::uint64_t* row = grid.row(y);
+        std::string& line = map[y];
+        for (int x = 0; x < grid.width(); ++x) {
+            if (!((row[x >> 6] >> (x & 63)) & 1u)) line[x] = TILE_FLOOR;
+        }
+    }
+    return map;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "work_stealing_pool.hpp"
+
+// 按位压缩的网格：每行若干个 64 位字，第 x 位在第 x / 64 个字的第 x % 64 位。
+// 洞穴生成里 1 表示墙；行末多出来的填充位也保持为 1，
+// 这样最右一列的“右邻居”天然就是墙。
+class BitGrid {
+public:
+    BitGrid() = default;
+    BitGrid(int width, int height);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int wordsPerRow() const { return words_; }
+
+    bool get(int x, int y) const {
+        return (bits_[static_cast<std::size_t>(y) * words_ + (x >> 6)] >> (x & 63)) & 1u;
+    }
+    void set(int x, int y, bool v);
+
+    std::uint64_t* row(int y) { return bits_.data() + static_cast<std::size_t>(y) * words_; }
+    const std::uint64_t* row(int y) const { return bits_.data() + static_cast<std::size_t>(y) * words_; }
+
+    // 最后一个字里真正属于地图的位
+    std::uint64_t lastWordMask() const { return lastMask_; }
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    int words_ = 0;
+    std::uint64_t lastMask_ = 0;
+    std::vector<std::uint64_t> bits_;
+};
+
+struct CaveParams {
+    int width = 80;
+    int height = 40;
+    int fillPercent = 45;    // 初始随机墙的比例
+    int iterations = 5;      // 细胞自动机平滑次数
+    unsigned int seed = 0;
+};
+
+// 细胞自动机洞穴：随机填充后反复平滑，
+// 规则为“邻居墙数 >= 5 变墙，原来是墙且邻居墙数 >= 4 保持墙”。
+// 邻居计数用位运算加法器一次算 64 个格子；给了线程池时按行块并行。
+BitGrid generate_cave_bits(const CaveParams& params, WorkStealingPool* pool = nullptr);
+
+// 转成游戏使用的字符地图（墙 '#'，地板 '.'）
+std::vector<std::string> cave_to_map(const BitGrid& grid);
@@ -0,0 +1,174 @@
+#include "connectivity.hpp"
+#include "tile.hpp"
+#include <utility>
+#include <numeric>
+#include <algorithm>
+
+static const int DIRS[4][2] = {
+    { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }
+};
+
+int ConnectivityIndex::find(int l) const {
+    // const 查询不做路径压缩（可以多线程同时读），按秩合并保证树高为 O(log n)
+    while (parent[l] != l) {
+        l = parent[l];
+    }
+    return l;
+}
+
+int ConnectivityIndex::newLabel() {
+    int l = static_cast<int>(parent.size());
+    parent.push_back(l);
+    rank.push_back(0);
+    return l;
+}
+
+// 只留下根标签并从 0 开始连续编号，丢掉合并和切分留下的废弃标签
+void ConnectivityIndex::compact() {
+    std::vector<int> remap(parent.size(), -1);
+    int next = 0;
+    for (int& l : label) {
+        if (l == -1) continue;
+        int root = find(l);
+        if (remap[root] == -1) remap[root] = next++;
+        l = remap[root];
+    }
+
+    parent.resize(next);
+    std::iota(parent.begin(), parent.end(), 0);
+    rank.assign(next, 0);
+    // 至少再攒一倍（加一个下限）才重编号，摊到每次改动上是常数
+    compactAt = 2 * parent.size() + 64;
+}
+
+void ConnectivityIndex::unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return;
+    if (rank[a] < rank[b]) std::swap(a, b);
+    parent[b] = a;
+    if (rank[a] == rank[b]) ++rank[a];
+}
+
+int ConnectivityIndex::regionOf(int x, int y) const {
+    if (x < 0 || x >= width || y < 0 || y >= height) return -1;
+    int l = label[y * width + x];
+    return l == -1 ? -1 : find(l);
+}
+
+// 从 (x, y) 出发，把根为 fromRoot 的格子全部改成标签 to
+// fromRoot 为 -1 时表示还没打标签的可走格子（build 时使用）
+void ConnectivityIndex::flood(const std::vector<std::string>& map, int x, int y, int fromRoot, int to) {
+    auto matches = [&](int idx) {
+        int l = label[idx];
+        if (fromRoot == -1) return l == -1 && tile_walkable(map[idx / width][idx % width]);
+        return l != -1 && find(l) == fromRoot;
+    };
+
+    std::vector<int> stack;
+    int start = y * width + x;
+    if (!matches(start)) return;
+    label[start] = to;
+    stack.push_back(start);
+
+    while (!stack.empty()) {
+        int idx = stack.back();
+        stack.pop_back();
+        int cx = idx % width;
+        int cy = idx / width;
+
+        for (auto& d : DIRS) {
+            int nx = cx + d[0];
+            int ny = cy + d[1];
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height) continue;
+            int nIdx = ny * width + nx;
+            if (!matches(nIdx)) continue;
+            label[nIdx] = to;
+            stack.push_back(nIdx);
+        }
+    }
+}
+
+void ConnectivityIndex::build(const std::vector<std::string>& map) {
+    height = static_cast<int>(map.size());
+    width  = height > 0 ? static_cast<int>(map[0].size()) : 0;
+
+    label.assign(static_cast<std::size_t>(width) * height, -1);
+    parent.clear();
+    rank.clear();
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (label[y * width + x] == -1 && tile_walkable(map[y][x])) {
+                flood(map, x, y, -1, newLabel());
+            }
+        }
+    }
+    compactAt = 2 * parent.size() + 64;
+}
+
+int ConnectivityIndex::largestRegion() const {
+    std::vector<int> sizes(parent.size(), 0);
+    for (int l : label) {
+        if (l != -1) ++sizes[find(l)];
+    }
+    if (sizes.empty()) return -1;
+    auto best = std::max_element(sizes.begin(), sizes.end());
+    return *best > 0 ? static_cast<int>(best - sizes.begin()) : -1;
+}
+
+void ConnectivityIndex::keepOnly(int region) {
+    for (int& l : label) {
+        if (l != -1 && find(l) != region) l = -1;
+    }
+    compact();
+}
+
+void ConnectivityIndex::onTileChanged(const std::vector<std::string>& map, int x, int y) {
+    if (x < 0 || x >= width || y < 0 || y >= height) return;
+    int idx = y * width + x;
+    bool walkable = tile_walkable(map[y][x]);
+
+    if (walkable) {
+        if (label[idx] != -1) return;
+
+        // 挖开：接到相邻区域上，并把相邻的几个区域合并
+        int joined = -1;
+        for (auto& d : DIRS) {
+            int r = regionOf(x + d[0], y + d[1]);
+            if (r == -1) continue;
+            if (joined == -1) joined = r;
+            else              unite(joined, r);
+        }
+        label[idx] = joined != -1 ? joined : newLabel();
+        if (parent.size() >= compactAt) compact();
+        return;
+    }
+
+    if (label[idx] == -1) return;
+
+    // 填上：原区域可能被切成几块，从每个邻居重新泛洪出新标签
+    int oldRoot = find(label[idx]);
+    label[idx] = -1;
+
+    int walkableNeighbours = 0;
+    for (auto& d : DIRS) {
+        if (regionOf(x + d[0], y + d[1]) != -1) ++walkableNeighbours;
+    }
+    if (walkableNeighbours <= 1) return; // 死胡同尽头，不可能切断
+
+    // 第一个邻居所在的那一块不泛洪，留着原来的根标签：
+    // 其余邻居泛洪完以后，还挂在 oldRoot 下的正好是连着它的那一块
+    bool first = true;
+    for (auto& d : DIRS) {
+        int nx = x + d[0];
+        int ny = y + d[1];
+        if (regionOf(nx, ny) != oldRoot) continue;
+        if (first) {
+            first = false;
+            continue;
+        }
+        flood(map, nx, ny, oldRoot, newLabel());
+    }
+    if (parent.size() >= compactAt) compact();
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <string>
+
+// 连通区域索引：给每个可走格子一个区域标签，
+// 判断两个格子是否互相可达只需比较标签，O(1)。
+//
+// 标签之间用并查集合并：挖开一格时把相邻区域并起来，几乎不花时间；
+// 填上一格时可能把区域切开，只重新泛洪被影响的那一个区域。
+// 废弃的标签攒到一定数量后整体重新编号，长时间改地形内存也不会一直涨。
+class ConnectivityIndex {
+public:
+    ConnectivityIndex() = default;
+
+    // 生成地图后整体建一次
+    void build(const std::vector<std::string>& map);
+    bool built() const { return width > 0; }
+
+    // map[y][x] 已经改成新地形之后调用，增量更新标签
+    void onTileChanged(const std::vector<std::string>& map, int x, int y);
+
+    // 所在区域编号，不可走或越界返回 -1
+    int regionOf(int x, int y) const;
+
+    bool connected(int x0, int y0, int x1, int y1) const {
+        int a = regionOf(x0, y0);
+        return a != -1 && a == regionOf(x1, y1);
+    }
+
+    // 格子最多的区域编号，没有可走格子返回 -1
+    int largestRegion() const;
+    // 只保留区域 region，其余格子都标成不可走；
+    // 调用方负责把这些格子在地图上填成墙，保持两边一致
+    void keepOnly(int region);
+
+private:
+    int width = 0;
+    int height = 0;
+    std::vector<int> label;     // 每格的标签，-1 为不可走
+    std::vector<int> parent;    // 标签并查集
+    std::vector<int> rank;
+    std::size_t compactAt = 0;  // parent 长到这么大时重新编号
+
+    int find(int l) const;
+    int newLabel();
+    void compact();
+    void unite(int a, int b);
+    void flood(const std::vector<std::string>& map, int x, int y, int fromRoot, int to);
+};
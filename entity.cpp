@@ -1,4 +1,5 @@
 #include "entity.hpp"
+#include "tile.hpp"
 
 // 地图范围判断
 bool in_bounds(const std::vector<std::string>& map, int x, int y) {
@@ -10,8 +11,7 @@ bool in_bounds(const std::vector<std::string>& map, int x, int y) {
 // 地板判断（不考虑实体，只看地图）
 bool is_walkable_tile(const std::vector<std::string>& map, int x, int y) {
     if (!in_bounds(map, x, y)) return false;
-    char tile = map[y][x];
-    return tile == '.';
+    return tile_walkable(map[y][x]);
 }
 
 // 目标格子是否被阻挡（地图 + 实体）
@@ -1,27 +1,31 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstdint>
 
-enum class EntityType {
+enum class EntityType : std::uint8_t {
     Player,
     Monster,
     Item
 };
 
+// 原型编号，对应 prototype.hpp 里的原型表
+using ProtoId = std::uint16_t;
+
 // 游戏里的实体：玩家、怪物、尸体等
+// 只存会变化的状态，maxHp / attack / healAmount / 名字等共享数据在原型里
 struct Entity {
     int x;
     int y;
-    char glyph;   // 显示用字符，比如 '@', 'g', 'x'
-    bool blocks;  // 是否阻挡（活着的怪物和玩家阻挡，尸体可以不阻挡）
-    
-    EntityType type;
-
     int hp;
-    int maxHp;
-    int attack;
 
-    int healAmount;
+    ProtoId proto;  // 原型编号
+    char glyph;     // 显示用字符，比如 '@', 'g', 'x'（死亡后会变成尸体）
+    bool blocks;    // 是否阻挡（活着的怪物和玩家阻挡，尸体可以不阻挡）
+
+    EntityType type;
+
+    bool alerted;   // 怪物是否已经发现玩家（看到过或被攻击过）
 };
 
 // 地图/位置相关工具函数声明
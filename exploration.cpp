@@ -0,0 +1,65 @@
+#include "exploration.hpp"
+#include "tile.hpp"
+
+void ExplorationMap::build(const std::vector<std::string>& map) {
+    height = static_cast<int>(map.size());
+    width  = height > 0 ? static_cast<int>(map[0].size()) : 0;
+
+    exploredTotal = 0;
+    exploredWalkableTotal = 0;
+    revealedTurn = 0;
+    walkableTotal = 0;
+    for (const auto& row : map) {
+        for (char c : row) {
+            if (tile_walkable(c)) ++walkableTotal;
+        }
+    }
+
+    // 每层边长减半，直到整张地图缩成一个单元
+    levels.clear();
+    int cellSize = 2;
+    for (;;) {
+        Level lv;
+        lv.cellSize = cellSize;
+        lv.width  = (width + cellSize - 1) / cellSize;
+        lv.height = (height + cellSize - 1) / cellSize;
+        std::size_t n = static_cast<std::size_t>(lv.width) * lv.height;
+        lv.explored.assign(n, 0);
+        lv.exploredWalkable.assign(n, 0);
+        levels.push_back(std::move(lv));
+        if (cellSize >= width && cellSize >= height) break;
+        cellSize *= 2;
+    }
+}
+
+void ExplorationMap::reveal(int x, int y, bool walkable) {
+    ++exploredTotal;
+    ++revealedTurn;
+    if (walkable) ++exploredWalkableTotal;
+
+    for (Level& lv : levels) {
+        std::size_t idx = static_cast<std::size_t>(y / lv.cellSize) * lv.width + x / lv.cellSize;
+        ++lv.explored[idx];
+        if (walkable) ++lv.exploredWalkable[idx];
+    }
+}
+
+void ExplorationMap::onTileChanged(int x, int y, bool explored, bool wasWalkable, bool nowWalkable) {
+    if (wasWalkable == nowWalkable) return;
+    int delta = nowWalkable ? 1 : -1;
+    walkableTotal += delta;
+    if (!explored) return;
+
+    exploredWalkableTotal += delta;
+    for (Level& lv : levels) {
+        std::size_t idx = static_cast<std::size_t>(y / lv.cellSize) * lv.width + x / lv.cellSize;
+        lv.exploredWalkable[idx] += delta;
+    }
+}
+
+int ExplorationMap::levelFor(int maxWidth, int maxHeight) const {
+    for (int i = 0; i < levelCount(); ++i) {
+        if (levels[i].width <= maxWidth && levels[i].height <= maxHeight) return i;
+    }
+    return levelCount() - 1;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// 探索进度与小地图金字塔。
+//
+// 探索格子只会增加，所以统计量和金字塔都只在格子第一次被看到时增量更新：
+// 金字塔第 i 层的一个单元覆盖 2^(i+1) × 2^(i+1) 个格子，记录其中已探索的格子数
+// 和已探索的可走格子数。揭开一格只改每层里包含它的那一个单元，O(层数)。
+// 前端画小地图时挑一层放得下的，绘制开销只和小地图大小有关。
+class ExplorationMap {
+public:
+    struct Level {
+        int width = 0;             // 这一层的单元数
+        int height = 0;
+        int cellSize = 0;          // 每个单元覆盖 cellSize × cellSize 个格子（地图边缘可能不满）
+        std::vector<std::uint32_t> explored;          // 单元内已探索的格子数
+        std::vector<std::uint32_t> exploredWalkable;  // 其中可走的格子数
+    };
+
+    ExplorationMap() = default;
+
+    // 生成地图后整体建一次，此时全部未探索
+    void build(const std::vector<std::string>& map);
+
+    // (x, y) 第一次被看到时调用（调用方保证每格只调一次）
+    void reveal(int x, int y, bool walkable);
+
+    // 地形改变时调用，维护可走格子总数和已探索的可走格子数
+    void onTileChanged(int x, int y, bool explored, bool wasWalkable, bool nowWalkable);
+
+    // 新回合开始，清零本回合新揭开的格子数
+    void beginTurn() { revealedTurn = 0; }
+
+    int exploredCells() const { return exploredTotal; }
+    int exploredWalkableCells() const { return exploredWalkableTotal; }
+    int walkableCells() const { return walkableTotal; }
+    int revealedThisTurn() const { return revealedTurn; }
+
+    // 可走格子中已探索的比例，0 ~ 100
+    int percentExplored() const {
+        return walkableTotal > 0 ? exploredWalkableTotal * 100 / walkableTotal : 0;
+    }
+
+    int levelCount() const { return static_cast<int>(levels.size()); }
+    const Level& level(int i) const { return levels[i]; }
+
+    // 单元数不超过 maxWidth × maxHeight 的最精细的一层
+    int levelFor(int maxWidth, int maxHeight) const;
+
+private:
+    int width = 0;
+    int height = 0;
+    int exploredTotal = 0;
+    int exploredWalkableTotal = 0;
+    int walkableTotal = 0;
+    int revealedTurn = 0;
+    std::vector<Level> levels;
+};
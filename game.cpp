@@ -1,10 +1,13 @@
 #include "game.hpp"
 #include "entity.hpp"
+#include "tile.hpp"
+#include "cave_gen.hpp"
 #include <iostream>
 #include <cstdlib>   
 #include <ctime>     
 #include <algorithm> 
 #include <cmath>
+#include <chrono>
 
 // ------- 控制台清屏 -------
 
@@ -17,8 +20,6 @@ static void clear_screen() {
 // ------- ANSI 颜色（简单彩色控制台） -------
 
 static const char* COLOR_RESET   = "\x1b[0m";
-static const char* COLOR_WALL    = "\x1b[37m"; // 白
-static const char* COLOR_FLOOR   = "\x1b[90m"; // 暗灰
 static const char* COLOR_PLAYER  = "\x1b[32m"; // 绿
 static const char* COLOR_MONSTER = "\x1b[31m"; // 红
 static const char* COLOR_CORPSE  = "\x1b[35m"; // 紫    
@@ -78,11 +79,17 @@ static std::vector<std::pair<int,int>> bresenhamLine(int x0, int y0, int x1, int
 // ------- Game 成员函数实现 -------
 
 Game::Game() {
-    init();
+    init(static_cast<unsigned int>(std::time(nullptr)));
 }
 
-void Game::init() {
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
+Game::Game(unsigned int seed, DungeonKind kind, const CaveOptions& caves)
+    : dungeonKind(kind), caveOptions(caves) {
+    init(seed);
+    caveOptions.pool = nullptr; // 生成完就不再用池子，免得副本里留着悬空指针
+}
+
+void Game::init(unsigned int seed) {
+    rng.seed(seed);
 
     generateDungeon();
 
@@ -91,27 +98,71 @@ void Game::init() {
 
     visible.assign(height, std::vector<bool>(width, false));
     explored.assign(height, std::vector<bool>(width, false));
+    fovBox = TileRect{};
 
     logLines.clear();
     addLog("Welcome to the dungeon!");
 }
 
+int Game::randInt(int lo, int hi) {
+    std::uniform_int_distribution<int> dist(lo, hi);
+    return dist(rng);
+}
+
 void Game::generateDungeon() {
+    entities.clear();
+    inventory.clear();
+    connectivity = std::make_shared<ConnectivityIndex>();
+
+    switch (dungeonKind) {
+        case DungeonKind::Rooms:
+            generateRooms();
+            break;
+        case DungeonKind::Caves:
+            generateCaves();
+            break;
+    }
+
+    height = static_cast<int>(map.size());
+    width  = static_cast<int>(map[0].size());
+
+    if (!connectivity->built()) {
+        connectivity->build(map);
+    }
+    visibility.build(map);
+    exploration.build(map);
+    if (aiDriver == AiDriver::Scent) {
+        scent.build(map);
+        noise.build(map);
+    }
+    entityIndex->markDirty();
+
+    // 地图大小的寻路缓冲区在这里一次分配好，免得第一个怪物回合卡一下
+    std::size_t cells = static_cast<std::size_t>(width) * height;
+    reserve_search_scratch(cells);
+    ai->distance.assign(cells, PATH_UNREACHABLE);
+    ai->frontier.clear();
+    // 每只怪物最多占 coopWindow + 1 个 (格子, t)
+    ai->reservations.reset(width, height, coopWindow);
+    ai->reservations.reserveSlots(entities.size() * (coopWindow + 1));
+}
+
+void Game::generateRooms() {
     const int mapW = 40;
     const int mapH = 20;
     const int maxRooms = 8;
     const int roomMinSize = 4;
     const int roomMaxSize = 8;
 
-    map.assign(mapH, std::string(mapW, '#'));
+    map.assign(mapH, std::string(mapW, TILE_WALL));
 
     std::vector<Rect> rooms;
 
     for (int i = 0; i < maxRooms; ++i) {
-        int w = roomMinSize + std::rand() % (roomMaxSize - roomMinSize + 1);
-        int h = roomMinSize + std::rand() % (roomMaxSize - roomMinSize + 1);
-        int x = 1 + std::rand() % (mapW - w - 1);
-        int y = 1 + std::rand() % (mapH - h - 1);
+        int w = randInt(roomMinSize, roomMaxSize);
+        int h = randInt(roomMinSize, roomMaxSize);
+        int x = randInt(1, mapW - w - 1);
+        int y = randInt(1, mapH - h - 1);
 
         Rect newRoom{x, y, w, h};
 
@@ -127,7 +178,7 @@ void Game::generateDungeon() {
         // 挖房间
         for (int ry = y; ry < y + h; ++ry) {
             for (int rx = x; rx < x + w; ++rx) {
-                map[ry][rx] = '.';
+                map[ry][rx] = TILE_FLOOR;
             }
         }
 
@@ -138,21 +189,21 @@ void Game::generateDungeon() {
             int newCx  = newRoom.centerX();
             int newCy  = newRoom.centerY();
 
-            if (std::rand() % 2) {
+            if (randInt(0, 1)) {
                 // 先水平后垂直
                 for (int tx = std::min(prevCx, newCx); tx <= std::max(prevCx, newCx); ++tx) {
-                    map[prevCy][tx] = '.';
+                    map[prevCy][tx] = TILE_FLOOR;
                 }
                 for (int ty = std::min(prevCy, newCy); ty <= std::max(prevCy, newCy); ++ty) {
-                    map[ty][newCx] = '.';
+                    map[ty][newCx] = TILE_FLOOR;
                 }
             } else {
                 // 先垂直后水平
                 for (int ty = std::min(prevCy, newCy); ty <= std::max(prevCy, newCy); ++ty) {
-                    map[ty][prevCx] = '.';
+                    map[ty][prevCx] = TILE_FLOOR;
                 }
                 for (int tx = std::min(prevCx, newCx); tx <= std::max(prevCx, newCx); ++tx) {
-                    map[newCy][tx] = '.';
+                    map[newCy][tx] = TILE_FLOOR;
                 }
             }
         }
@@ -161,59 +212,77 @@ void Game::generateDungeon() {
     }
 
     // 创建玩家和怪物
-    entities.clear();
-    inventory.clear();
-
     if (!rooms.empty()) {
+        const PrototypeTable& protos = prototypes();
+        ProtoId playerProto = protos.find("player");
+        ProtoId goblinProto = protos.find("goblin");
+        ProtoId orcProto    = protos.find("orc");
+        ProtoId potionProto = protos.find("healing_potion");
+
         // 玩家在第一个房间中心
         Rect& first = rooms[0];
-        int px = first.centerX();
-        int py = first.centerY();
-
-        Entity player;
-        player.x = px;
-        player.y = py;
-        player.glyph    = '@';
-        player.blocks   = true;
-        player.type = EntityType::Player;
-        player.maxHp    = 30;
-        player.hp       = 30;
-        player.attack   = 6;
-        entities.push_back(player);
-
-        // 每个其他房间中心放一只怪物
+        entities.push_back(make_entity(playerProto, first.centerX(), first.centerY()));
+
+        // 每个其他房间中心放一只怪物，旁边放一瓶药水
         for (std::size_t i = 1; i < rooms.size(); ++i) {
             Rect& rm = rooms[i];
             int mx = rm.centerX();
             int my = rm.centerY();
 
-            Entity m;
-            m.x = mx;
-            m.y = my;
-            m.glyph    = (i % 2 == 0) ? 'g' : 'o';
-            m.blocks   = true;
-            m.type = EntityType::Monster;
-            m.maxHp    = 12;
-            m.hp       = 12;
-            m.attack   = 4;
-            entities.push_back(m);
-
-            Entity potion;
-            potion.x = mx + 1;
-            potion.y = my + 1;
-            potion.glyph = '!';
-            potion.blocks = false;
-            potion.type = EntityType::Item;
-            potion.maxHp = 0;
-            potion.hp = 0;
-            potion.attack = 0;
-            potion.healAmount = 10;
-            entities.push_back(potion);
+            entities.push_back(make_entity((i % 2 == 0) ? goblinProto : orcProto, mx, my));
+            entities.push_back(make_entity(potionProto, mx + 1, my + 1));
         }
     }
+}
 
-    height = mapH;
-    width  = mapW;
+void Game::generateCaves() {
+    CaveParams params;
+    params.width  = caveOptions.width;
+    params.height = caveOptions.height;
+    params.seed   = rng();
+
+    map = cave_to_map(generate_cave_bits(params, caveOptions.pool));
+
+    // 只保留最大的连通区域，洞穴里的小气泡填成墙。
+    // 索引在这里建好，generateDungeon 就不用再建一遍
+    connectivity->build(map);
+    int largest = connectivity->largestRegion();
+    connectivity->keepOnly(largest);
+    for (int y = 0; y < params.height; ++y) {
+        for (int x = 0; x < params.width; ++x) {
+            if (tile_walkable(map[y][x]) && connectivity->regionOf(x, y) == -1) {
+                map[y][x] = TILE_WALL;
+            }
+        }
+    }
+
+    std::vector<std::pair<int,int>> floors;
+    for (int y = 0; y < params.height; ++y) {
+        for (int x = 0; x < params.width; ++x) {
+            if (tile_walkable(map[y][x])) floors.emplace_back(x, y);
+        }
+    }
+    if (floors.empty()) return;
+
+    // 打乱后依次取不同的格子：第一个给玩家，之后怪物和药水交替
+    std::shuffle(floors.begin(), floors.end(), rng);
+
+    const PrototypeTable& protos = prototypes();
+    ProtoId playerProto = protos.find("player");
+    ProtoId goblinProto = protos.find("goblin");
+    ProtoId orcProto    = protos.find("orc");
+    ProtoId potionProto = protos.find("healing_potion");
+
+    entities.push_back(make_entity(playerProto, floors[0].first, floors[0].second));
+
+    // 大约每 150 格地板一只怪物
+    std::size_t monsters = floors.size() / 150 + 1;
+    for (std::size_t i = 0; i < monsters && 2 + 2 * i < floors.size(); ++i) {
+        auto [mx, my] = floors[1 + 2 * i];
+        auto [ix, iy] = floors[2 + 2 * i];
+        entities.push_back(make_entity((i % 2 == 0) ? goblinProto : orcProto, mx, my));
+        entities.push_back(make_entity(potionProto, ix, iy));
+    }
 }
 
 // 视野计算（FoV）：从玩家出发，以半径 fovRadius 做线性 FoV
@@ -221,9 +290,9 @@ void Game::updateFov() {
     if (entities.empty()) return;
     const Entity& player = entities[0];
 
-    // 清空可见性
-    for (int y = 0; y < height; ++y) {
-        std::fill(visible[y].begin(), visible[y].end(), false);
+    // 清空可见性：只有上一次视野的外接矩形里可能有可见格子
+    for (int y = fovBox.y0; y < fovBox.y1; ++y) {
+        std::fill(visible[y].begin() + fovBox.x0, visible[y].begin() + fovBox.x1, false);
     }
 
     int px = player.x;
@@ -232,6 +301,11 @@ void Game::updateFov() {
     int r = fovRadius;
     int r2 = r * r;
 
+    fovBox.x0 = std::max(px - r, 0);
+    fovBox.y0 = std::max(py - r, 0);
+    fovBox.x1 = std::min(px + r + 1, width);
+    fovBox.y1 = std::min(py + r + 1, height);
+
     for (int y = py - r; y <= py + r; ++y) {
         for (int x = px - r; x <= px + r; ++x) {
             if (!in_bounds(map, x, y)) continue;
@@ -250,9 +324,13 @@ void Game::updateFov() {
                 if (!in_bounds(map, lx, ly)) break;
 
                 visible[ly][lx]  = true;
-                explored[ly][lx] = true;
+                if (!explored[ly][lx]) {
+                    explored[ly][lx] = true;
+                    exploration.reveal(lx, ly, tile_walkable(map[ly][lx]));
+                }
 
-                if (map[ly][lx] == '#' && i + 1 < line.size()) {
+                // 起点不挡视线（站在门口也能看出去），和 VisibilityEngine 规则一致
+                if (i > 0 && i + 1 < line.size() && tile_opaque(map[ly][lx])) {
                     blocked = true;
                     break;
                 }
@@ -270,21 +348,34 @@ void Game::addLog(const std::string& msg) {
     }
 }
 
-void Game::render() const {
-    clear_screen();
+void Game::entitiesIn(const TileRect& rect, std::vector<std::size_t>& out) const {
+    entityIndex->query(entities, width, height, rect, out);
+}
 
-    // 重新计算 FoV
-    // 注意：updateFov 修改成员，因此这里不能是 const 函数调用；
-    // 我们在 const 函数外调用它，在 main 里控制调用顺序。
-    // 这里为了简单起见，我们假装 render 之前刚刚调用了 updateFov。
-    // 如果你想在 render 内部调用，需要把 updateFov 去掉 const 限制。
+void Game::render(const Viewport& camera) const {
+    clear_screen();
 
-    int h = height;
-    int w = width;
+    // 注意：render 假设外面刚刚调用过 updateFov（每次行动之后都会算）
+
+    // 只画视口里的格子；视口里的实体先查块索引，放进和视口一样大的格子表，
+    // 同一格有多个实体时取下标最小的（和以前逐个查找的结果一样）
+    TileRect view = camera.visibleTiles();
+    int viewW = view.x1 - view.x0;
+    int viewH = view.y1 - view.y0;
+    if (viewW <= 0 || viewH <= 0) return;
+
+    std::vector<std::size_t> inView;
+    entitiesIn(view, inView);
+    std::vector<const Entity*> cells(static_cast<std::size_t>(viewW) * viewH, nullptr);
+    for (std::size_t i : inView) {
+        const Entity& e = entities[i];
+        const Entity*& cell = cells[(e.y - view.y0) * viewW + (e.x - view.x0)];
+        if (!cell) cell = &e;
+    }
 
     // 画地图 + 实体
-    for (int y = 0; y < h; ++y) {
-        for (int x = 0; x < w; ++x) {
+    for (int y = view.y0; y < view.y1; ++y) {
+        for (int x = view.x0; x < view.x1; ++x) {
             bool isExplored = explored[y][x];
             bool isVisible  = visible[y][x];
 
@@ -293,21 +384,16 @@ void Game::render() const {
                 continue;
             }
 
-            char baseTile = map[y][x];
-            char drawCh   = baseTile;
+            const TileTraits& tile = tile_traits(map[y][x]);
+            char drawCh = tile.glyph;
 
             const Entity* entToDraw = nullptr;
 
             if (isVisible) {
-                for (const auto& e : entities) {
-                    if (e.x == x && e.y == y) {
-                        entToDraw = &e;
-                        break;
-                    }
-                }
+                entToDraw = cells[(y - view.y0) * viewW + (x - view.x0)];
             }
 
-            const char* color = COLOR_FLOOR;
+            const char* color = tile.consoleColor;
 
             if (!isVisible) {
                 color = COLOR_DARK;
@@ -325,9 +411,6 @@ void Game::render() const {
                         break;
                 }
                 drawCh = entToDraw->glyph;
-            } else {
-                if (baseTile == '#') color = COLOR_WALL;
-                else                 color = COLOR_FLOOR;
             }
 
             std::cout << color << drawCh << COLOR_RESET;
@@ -338,12 +421,18 @@ void Game::render() const {
     // HUD：玩家状态
     if (!entities.empty()) {
         const Entity& player = entities[0];
-        std::cout << "HP: " << player.hp << " / " << player.maxHp << "\n";
+        std::cout << "HP: " << player.hp << " / " << proto_of(player).maxHp << "\n";
     }
 
+    std::cout << "Explored: " << exploration.percentExplored() << "%";
+    if (exploration.revealedThisTurn() > 0) {
+        std::cout << " (+" << exploration.revealedThisTurn() << ")";
+    }
+    std::cout << "\n";
+
     int potionCount = 0;
     for (const auto& item : inventory) {
-        potionCount += item.healAmount > 0 ? 1 : 0;
+        if (prototypes()[item.proto].healAmount > 0) potionCount += item.count;
     }
     std::cout << "Potions in inventory: " << potionCount << "\n";
 
@@ -387,55 +476,391 @@ void Game::handleInput(char command, bool& running) {
 }
 
 // 怪物朝玩家靠近，如果要走到玩家位置就攻击
+//
+// 怪物先批量做一次视线检测，看到过玩家（或者被玩家打过）的怪物才会追击。
+// 追击的怪物在一次批量的协同寻路里规划：
+// 1. 从玩家做一次 BFS 得到距离场，所有怪物共用它做启发函数
+// 2. 离玩家近的怪物先规划，把未来几步写进预约表
+// 3. 后面的怪物绕开这些预约（或者原地等一步），不会再撞上别的怪物
 void Game::updateMonsters(bool& running) {
+    beginMonsterTurn();
+    stepMonsterTurn(running, std::chrono::microseconds(0));
+}
+
+// 回合开始：只做常数量的准备，感知、排序、预约和行动都由 stepMonsterTurn 分片执行
+void Game::beginMonsterTurn() {
     Entity& player = entities[0];
 
-    for (std::size_t i = 1; i < entities.size(); ++i) {
-        Entity& monster = entities[i];
-        if (monster.hp <= 0) continue; // 死了就不动
-
-        // 1. 用 A* 计算从怪物到玩家的路径
-        Path path = find_path(map,
-                              monster.x, monster.y,
-                              player.x,  player.y);
-
-        // [0] = 当前怪物位置, [1] = 下一步, ..., [N-1] = 玩家位置
-        if (path.size() >= 2) {
-            int nextX = path[1].first;
-            int nextY = path[1].second;
-
-            // 2. 如果下一步就是玩家所在的格子 → 攻击玩家
-            if (nextX == player.x && nextY == player.y) {
-                player.hp -= monster.attack;
-                addLog("Monster " + std::string(1, monster.glyph) +
-                       " hits you for " + std::to_string(monster.attack) +
-                       " damage! (HP = " + std::to_string(player.hp) + ")");
-
-                if (player.hp <= 0) {
-                    addLog("You died!");
-                    running = false;
-                    return;
+    // 气味驱动：玩家在脚下留下气味，气味和噪音各自扩散一回合
+    //（开销只和气味场的活跃格子数有关）
+    if (aiDriver == AiDriver::Scent) {
+        scent.deposit(player.x, player.y, SCENT_DEPOSIT);
+        scent.advanceTurn();
+        noise.advanceTurn();
+    }
+
+    ai->active.clear();
+    turnOrder.clear();
+    turnPhase   = TurnPhase::Collect;
+    turnCursor  = 0;
+    turnPending = true;
+}
+
+bool Game::stepMonsterTurn(bool& running, std::chrono::microseconds budget) {
+    if (!turnPending) return true;
+
+    auto start = std::chrono::steady_clock::now();
+    while (turnPhase != TurnPhase::Done) {
+        runTurnSlice(running);
+        if (!running) {
+            turnOrder.clear();
+            turnPending = false;
+            return true;
+        }
+
+        // 每做完一片看一下时间，超了就留到下一帧
+        if (budget.count() > 0 && turnPhase != TurnPhase::Done &&
+            std::chrono::steady_clock::now() - start >= budget) {
+            return false;
+        }
+    }
+
+    // 怪物行动后重新计算视野
+    updateFov();
+    turnOrder.clear();
+    turnPending = false;
+    return true;
+}
+
+// 一片：当前阶段从 turnCursor 开始处理最多 TURN_SLICE 个对象（行动阶段每片一只怪物），
+// 这一阶段做完就切到下一阶段
+void Game::runTurnSlice(bool& running) {
+    const Entity& player = entities[0];
+    auto nextPhase = [this](TurnPhase phase) {
+        turnPhase  = phase;
+        turnCursor = 0;
+    };
+
+    switch (turnPhase) {
+    case TurnPhase::Collect: {
+        // 活着并且和玩家在同一连通区域的怪物；被隔开的怪物永远追不到玩家，
+        // 也不会和能追到的怪物抢格子，直接跳过
+        std::size_t end = std::min(entities.size(), turnCursor + TURN_SLICE);
+        for (std::size_t i = std::max<std::size_t>(turnCursor, 1); i < end; ++i) {
+            const Entity& monster = entities[i];
+            if (monster.type != EntityType::Monster || monster.hp <= 0) continue;
+            if (!connectivity->connected(monster.x, monster.y, player.x, player.y)) continue;
+            ai->active.push_back(i);
+        }
+        turnCursor = end;
+        if (turnCursor >= entities.size()) nextPhase(TurnPhase::Perceive);
+        break;
+    }
+
+    case TurnPhase::Perceive: {
+        // 还没发现玩家的怪物一批一批地看一眼玩家，
+        // 每片按查询数（而不是扫过的怪物数）凑满 PERCEIVE_SLICE
+        const std::vector<std::size_t>& active = ai->active;
+        std::size_t end = turnCursor;
+        ai->queries.clear();
+        ai->watchers.clear();
+        while (end < active.size() && ai->queries.size() < PERCEIVE_SLICE) {
+            const Entity& monster = entities[active[end]];
+            if (!monster.alerted) {
+                ai->queries.push_back({ monster.x, monster.y, player.x, player.y });
+                ai->watchers.push_back(active[end]);
+            }
+            ++end;
+        }
+        visibility.batchLineOfSight(ai->queries, sightRadius, ai->seen, workers);
+        for (std::size_t k = 0; k < ai->watchers.size(); ++k) {
+            if (!ai->seen[k]) continue;
+            Entity& monster = entities[ai->watchers[k]];
+            monster.alerted = true;
+            addLog("Monster " + std::string(1, monster.glyph) + " notices you!");
+        }
+        turnCursor = end;
+        if (turnCursor >= active.size()) nextPhase(TurnPhase::Wake);
+        break;
+    }
+
+    case TurnPhase::Wake: {
+        // 气味驱动下，听到打斗声或者闻到气味的怪物也会醒过来；
+        // 醒着的怪物按原来的顺序排进本回合的行动列表
+        const std::vector<std::size_t>& active = ai->active;
+        std::size_t end = std::min(active.size(), turnCursor + TURN_SLICE);
+        for (std::size_t k = turnCursor; k < end; ++k) {
+            Entity& monster = entities[active[k]];
+            if (aiDriver == AiDriver::Scent && !monster.alerted) {
+                if (noise.value(monster.x, monster.y) > 0.0f) {
+                    monster.alerted = true;
+                    addLog("Monster " + std::string(1, monster.glyph) + " hears something!");
+                } else if (scent.value(monster.x, monster.y) >= SCENT_WAKE_THRESHOLD) {
+                    monster.alerted = true;
+                    addLog("Monster " + std::string(1, monster.glyph) + " picks up your scent!");
                 }
-            } else {
-                // 3. 否则尝试向该格子移动（考虑其他怪物/墙的阻挡）
-                int dx = nextX - monster.x;
-                int dy = nextY - monster.y;
-                try_move_entity(monster, map, entities, dx, dy);
             }
+            if (monster.alerted) turnOrder.push_back(active[k]);
+        }
+        turnCursor = end;
+        if (turnCursor >= active.size()) {
+            nextPhase(turnOrder.empty() ? TurnPhase::Done : TurnPhase::Plan);
+        }
+        break;
+    }
+
+    case TurnPhase::Plan:
+        if (aiDriver == AiDriver::Scent) {
+            planScentTurn();
         } else {
-            //
-            //
+            planCooperativeTurn();
+        }
+        nextPhase(TurnPhase::ReserveIdle);
+        break;
+
+    case TurnPhase::ReserveIdle: {
+        // 协同寻路：没发现玩家的怪物待在原地，整个窗口都占着自己的格子。
+        // 气味驱动：预约表只用第 0 层当占用表，同一区域里所有活着的怪物都占着自己的格子
+        const std::vector<std::size_t>& active = ai->active;
+        std::size_t end = std::min(active.size(), turnCursor + TURN_SLICE);
+        for (std::size_t k = turnCursor; k < end; ++k) {
+            const Entity& monster = entities[active[k]];
+            int agent = static_cast<int>(active[k]);
+            if (aiDriver == AiDriver::Scent) {
+                ai->reservations.reserve(monster.x, monster.y, 0, agent);
+            } else if (!monster.alerted) {
+                Path stay{ { monster.x, monster.y } };
+                ai->reservations.reservePath(stay, agent, true);
+            }
+        }
+        turnCursor = end;
+        if (turnCursor >= active.size()) {
+            nextPhase(aiDriver == AiDriver::Scent ? TurnPhase::Act : TurnPhase::ReserveOrder);
         }
+        break;
     }
 
-    // 怪物行动后重新计算视野
-    updateFov();
+    case TurnPhase::ReserveOrder: {
+        // 还没规划的怪物先占住自己当前的格子（第 0、1 步），
+        // 避免先规划的怪物把下一步规划到它们身上
+        std::size_t end = std::min(turnOrder.size(), turnCursor + TURN_SLICE);
+        for (std::size_t k = turnCursor; k < end; ++k) {
+            const Entity& monster = entities[turnOrder[k]];
+            int agent = static_cast<int>(turnOrder[k]);
+            ai->reservations.reserve(monster.x, monster.y, 0, agent);
+            ai->reservations.reserve(monster.x, monster.y, 1, agent);
+        }
+        turnCursor = end;
+        if (turnCursor >= turnOrder.size()) nextPhase(TurnPhase::Act);
+        break;
+    }
+
+    case TurnPhase::Act:
+        actMonster(turnOrder[turnCursor++], running);
+        if (turnCursor >= turnOrder.size()) nextPhase(TurnPhase::Done);
+        break;
+
+    case TurnPhase::Done:
+        break;
+    }
+}
+
+// 协同寻路的回合规划：距离场、规划顺序、清空预约表
+void Game::planCooperativeTurn() {
+    const Entity& player = entities[0];
+
+    // 距离场有展开预算，缓冲区每回合复用，大地图上也不会整图 BFS 或整图清零
+    distance_field(map, player.x, player.y, aiNodeBudget, ai->distance, ai->frontier);
+    const std::vector<int>& dist = ai->distance;
+
+    // 离玩家近的先规划，超出距离场预算的远处怪物排最后
+    std::stable_sort(turnOrder.begin(), turnOrder.end(), [&](std::size_t a, std::size_t b) {
+        int da = dist[entities[a].y * width + entities[a].x];
+        int db = dist[entities[b].y * width + entities[b].x];
+        if (da == PATH_UNREACHABLE) return false;
+        if (db == PATH_UNREACHABLE) return true;
+        return da < db;
+    });
+
+    if (ai->reservations.depth() != coopWindow) {
+        ai->reservations.reset(width, height, coopWindow);
+    } else {
+        ai->reservations.clear();
+    }
+}
+
+// 一只追击中的怪物：协同寻路 + 移动或攻击
+void Game::actMonster(std::size_t i, bool& running) {
+    if (aiDriver == AiDriver::Scent) {
+        actMonsterScent(i, running);
+        return;
+    }
+
+    Entity& player  = entities[0];
+    Entity& monster = entities[i];
+    int agent = static_cast<int>(i);
+    const std::vector<int>& dist = ai->distance;
+
+    ai->reservations.release(monster.x, monster.y, 1, agent);
+
+    Path path;
+    if (dist[monster.y * width + monster.x] != PATH_UNREACHABLE) {
+        // 1. 在时空里规划，从怪物到玩家
+        path = find_path_cooperative(map, dist, ai->reservations, agent,
+                                     monster.x, monster.y,
+                                     player.x,  player.y);
+    } else {
+        // 1'. 距离场预算之外的远处怪物：有预算的普通寻路，
+        //     朝玩家（或预算内最接近玩家的格子）走一步，被预约了就原地等
+        PathResult far = find_path(map, monster.x, monster.y,
+                                   player.x, player.y, farPathOptions);
+        path.push_back({ monster.x, monster.y });
+        if (far.path.size() >= 2 &&
+            !ai->reservations.conflicts(agent, monster.x, monster.y,
+                                    far.path[1].first, far.path[1].second, 0)) {
+            path.push_back(far.path[1]);
+        }
+    }
+
+    if (path.empty()) {
+        // 到不了或者被完全堵死：原地不动，继续占着这一格
+        Path stay{ { monster.x, monster.y } };
+        ai->reservations.reservePath(stay, agent, true);
+        return;
+    }
+
+    // 走到玩家身边以后就停在原地攻击，所以预约时去掉终点（玩家格），
+    // 一直占着攻击位置
+    Path planned = path;
+    if (planned.size() >= 2 &&
+        planned.back().first == player.x && planned.back().second == player.y) {
+        planned.pop_back();
+    }
+    ai->reservations.reservePath(planned, agent, true);
+
+    // [0] = 当前怪物位置, [1] = 下一步（可能是原地等待）, ...
+    if (path.size() < 2) return;
+    int nextX = path[1].first;
+    int nextY = path[1].second;
+
+    // 2. 如果下一步就是玩家所在的格子 → 攻击玩家
+    if (nextX == player.x && nextY == player.y) {
+        monsterAttack(monster, running);
+    } else {
+        // 3. 预约表已经保证这一格没有别的怪物，直接走过去
+        entityIndex->onEntityMoved(i, monster.x, monster.y, nextX, nextY);
+        monster.x = nextX;
+        monster.y = nextY;
+    }
+}
+
+void Game::monsterAttack(Entity& monster, bool& running) {
+    Entity& player = entities[0];
+    int attack = proto_of(monster).attack;
+    player.hp -= attack;
+    addLog("Monster " + std::string(1, monster.glyph) +
+           " hits you for " + std::to_string(attack) +
+           " damage! (HP = " + std::to_string(player.hp) + ")");
+    makeNoise(player.x, player.y);
+
+    if (player.hp <= 0) {
+        addLog("You died!");
+        running = false;
+    }
+}
+
+void Game::makeNoise(int x, int y) {
+    if (aiDriver == AiDriver::Scent) noise.deposit(x, y, NOISE_DEPOSIT);
+}
+
+void Game::setAiDriver(AiDriver driver) {
+    aiDriver = driver;
+    if (aiDriver == AiDriver::Scent && !scent.built()) {
+        scent.build(map);
+        noise.build(map);
+    }
+}
+
+// 气味驱动的回合规划：不需要距离场，预约表只用第 0 层当占用表，
+// 怪物之间靠它避免走到同一格
+void Game::planScentTurn() {
+    // 气味最浓（离玩家最近）的先走，给后面的让出位置
+    std::stable_sort(turnOrder.begin(), turnOrder.end(), [&](std::size_t a, std::size_t b) {
+        return scent.value(entities[a].x, entities[a].y) > scent.value(entities[b].x, entities[b].y);
+    });
+
+    if (ai->reservations.depth() != coopWindow) {
+        ai->reservations.reset(width, height, coopWindow);
+    } else {
+        ai->reservations.clear();
+    }
+}
+
+// 一只追击中的怪物，气味驱动：挨着玩家就攻击，否则往相邻格子里气味最浓的走一步。
+// 周围闻不到气味时（比如刚看到玩家、气味还没扩散过来）直接朝玩家方向迈一步
+void Game::actMonsterScent(std::size_t i, bool& running) {
+    Entity& player  = entities[0];
+    Entity& monster = entities[i];
+    int agent = static_cast<int>(i);
+
+    int dx = player.x - monster.x;
+    int dy = player.y - monster.y;
+    if (std::abs(dx) + std::abs(dy) == 1) {
+        monsterAttack(monster, running);
+        return;
+    }
+
+    auto canEnter = [&](int x, int y) {
+        if (!is_walkable_tile(map, x, y)) return false;
+        if (x == player.x && y == player.y) return false;
+        int owner = ai->reservations.ownerAt(x, y, 0);
+        return owner == -1 || owner == agent;
+    };
+
+    static const int DIRS[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+    float best = scent.value(monster.x, monster.y);
+    int nextX = monster.x;
+    int nextY = monster.y;
+    for (auto& d : DIRS) {
+        int nx = monster.x + d[0];
+        int ny = monster.y + d[1];
+        float v = scent.value(nx, ny);
+        if (v > best && canEnter(nx, ny)) {
+            best = v;
+            nextX = nx;
+            nextY = ny;
+        }
+    }
+
+    if (best == 0.0f) {
+        // 没有梯度：沿差得多的那个轴朝玩家走
+        int sx = (dx > 0) - (dx < 0);
+        int sy = (dy > 0) - (dy < 0);
+        if (std::abs(dx) >= std::abs(dy) && canEnter(monster.x + sx, monster.y)) {
+            nextX = monster.x + sx;
+        } else if (sy != 0 && canEnter(monster.x, monster.y + sy)) {
+            nextY = monster.y + sy;
+        } else if (sx != 0 && canEnter(monster.x + sx, monster.y)) {
+            nextX = monster.x + sx;
+        }
+    }
+
+    if (nextX == monster.x && nextY == monster.y) return;
+
+    ai->reservations.release(monster.x, monster.y, 0, agent);
+    ai->reservations.reserve(nextX, nextY, 0, agent);
+    entityIndex->onEntityMoved(i, monster.x, monster.y, nextX, nextY);
+    monster.x = nextX;
+    monster.y = nextY;
 }
 
 //单独封装移动命令
 void Game::stepPlayerMove(int dx, int dy, bool& running) {
     Entity & player = entities[0];
 
+    // 玩家每次行动算一个新回合
+    exploration.beginTurn();
+
     if (dx == 0 && dy == 0) return;
 
     int targetX = player.x + dx;
@@ -445,10 +870,13 @@ void Game::stepPlayerMove(int dx, int dy, bool& running) {
     if (monsterIndex != -1) {
         // 攻击怪物
         Entity& m = entities[monsterIndex];
-        m.hp -= player.attack;
+        int attack = proto_of(player).attack;
+        m.hp -= attack;
+        m.alerted = true; // 挨了打当然知道玩家在哪
+        makeNoise(targetX, targetY);
 
         addLog("You hit " + std::string(1, m.glyph) +
-               " for " + std::to_string(player.attack) +
+               " for " + std::to_string(attack) +
                " damage (HP=" + std::to_string(m.hp) + ")");
 
         if (m.hp <= 0) {
@@ -458,12 +886,32 @@ void Game::stepPlayerMove(int dx, int dy, bool& running) {
         }
     } else {
         // 没有怪物，就尝试移动
+        int oldX = player.x;
+        int oldY = player.y;
         try_move_entity(player, map, entities, dx, dy);
+        entityIndex->onEntityMoved(0, oldX, oldY, player.x, player.y);
     }
 
     updateFov();
 }
 
+void Game::setTile(int x, int y, char tile) {
+    if (!in_bounds(map, x, y) || map[y][x] == tile) return;
+    bool wasWalkable = tile_walkable(map[y][x]);
+    map[y][x] = tile;
+    exploration.onTileChanged(x, y, explored[y][x], wasWalkable, tile_walkable(tile));
+    if (connectivity.use_count() > 1) {
+        // 和别的 Game 副本共享着，先拷一份自己的再改
+        connectivity = std::make_shared<ConnectivityIndex>(*connectivity);
+    }
+    connectivity->onTileChanged(map, x, y);
+    visibility.onTileChanged(map, x, y);
+    if (scent.built()) {
+        scent.onTileChanged(map, x, y);
+        noise.onTileChanged(map, x, y);
+    }
+}
+
 void Game::pickUp() {
     Entity& player = entities[0];
 
@@ -471,16 +919,21 @@ void Game::pickUp() {
         Entity & e = entities[i];
 
         if (e.type == EntityType::Item && e.x == player.x && e.y == player.y) {
-            InventoryItem item;
+            ProtoId proto = e.proto;
 
-            item.name = "Healing Potion";
-            item.healAmount = e.healAmount;
-
-            inventory.push_back(item);
+            // 同种道具叠在同一个格子里
+            auto stack = std::find_if(inventory.begin(), inventory.end(),
+                                      [proto](const InventoryItem& item) { return item.proto == proto; });
+            if (stack != inventory.end()) {
+                ++stack->count;
+            } else {
+                inventory.push_back({ proto, 1 });
+            }
 
-            addLog("You pick up a " + item.name + "!");
+            addLog("You pick up a " + prototypes()[proto].name + "!");
 
             entities.erase(entities.begin() + static_cast<long>(i));
+            entityIndex->markDirty();
             return;
         }
     }
@@ -494,16 +947,19 @@ void Game::useFirstItem() {
         return;
     }
 
-    InventoryItem item = inventory.front();
-    inventory.erase(inventory.begin());
+    const Prototype& item = prototypes()[inventory.front().proto];
+    if (--inventory.front().count <= 0) {
+        inventory.erase(inventory.begin());
+    }
 
     Entity& player = entities[0];
     int oldHp = player.hp;
+    int maxHp = proto_of(player).maxHp;
 
     player.hp += item.healAmount;
 
-    if (player.hp > player.maxHp) {
-        player.hp = player.maxHp;
+    if (player.hp > maxHp) {
+        player.hp = maxHp;
     }
 
     int healed = player.hp - oldHp;
@@ -1,22 +1,66 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <random>
+#include <chrono>
 #include "entity.hpp"
+#include "prototype.hpp"
 #include "pathfinding.hpp"
+#include "connectivity.hpp"
+#include "visibility.hpp"
+#include "viewport.hpp"
+#include "exploration.hpp"
+#include "scent.hpp"
+#include "transient.hpp"
+#include <memory>
+#include "work_stealing_pool.hpp"
 
+// 地牢类型：房间 + 走廊，或者细胞自动机洞穴
+enum class DungeonKind {
+    Rooms,
+    Caves
+};
+
+// 怪物追击方式：协同 A*（默认），或者沿气味场爬坡（每只怪物每步只看相邻格子）
+enum class AiDriver {
+    Cooperative,
+    Scent
+};
+
+// 洞穴地图的尺寸；pool 不为空时细胞自动机按行块在池子上并行。
+// 池子只在构造 Game 时借用，Game 不保留这个指针
+struct CaveOptions {
+    int width = 80;
+    int height = 40;
+    WorkStealingPool* pool = nullptr;
+};
+
+// 背包格子：相同原型的道具堆叠在一起
 struct InventoryItem {
-    std::string name;
-    int healAmount;
+    ProtoId proto;
+    int count;
 };
 
 class Game {
 public:
-    Game();
+    Game();                              // 用当前时间做随机种子
+    explicit Game(unsigned int seed,     // 固定种子：可复现，方便 bot / 测试
+                  DungeonKind kind = DungeonKind::Rooms,
+                  const CaveOptions& caves = CaveOptions());
 
-    void render() const;                 // 渲染
+    void render(const Viewport& camera) const; // 渲染（只画相机视口内的部分）
     void handleInput(char command, bool& running); // 处理玩家输入
     void updateMonsters(bool& running);  // 更新怪物 
 
+    // 分帧执行怪物回合：beginMonsterTurn 之后反复调用 stepMonsterTurn，
+    // 每次在 budget 时间内尽量多做几片（0 表示不限），整回合处理完返回 true。
+    // 感知、排序、预约和行动都是分片做的，每片之后检查时间，所以怪物再多
+    // 一次调用也只会超出预算一片的时间。
+    // 回合进行中 monsterTurnPending() 为 true，这时不应处理玩家输入，也不要复制 Game
+    void beginMonsterTurn();
+    bool stepMonsterTurn(bool& running, std::chrono::microseconds budget);
+    bool monsterTurnPending() const { return turnPending; }
+
     const std::vector<InventoryItem>& getInventory() const { return inventory;}
 
     //给图形化提供接口
@@ -25,9 +69,29 @@ public:
     const std::vector<std::vector<bool>>& getVisible() const {return visible;}
     const std::vector<std::vector<bool>>& getExplored() const {return explored;}
     const std::vector<std::string>& getLog() const {return logLines;}
+    const ExplorationMap& getExploration() const { return exploration; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // 落在 rect 内的实体下标（升序），给前端做视口裁剪
+    void entitiesIn(const TileRect& rect, std::vector<std::size_t>& out) const;
 
     void stepPlayerMove(int dx, int dy, bool& running);
 
+    // 修改一个格子的地形（开门、挖墙等），同时更新连通区域索引
+    void setTile(int x, int y, char tile);
+    const ConnectivityIndex& getConnectivity() const { return *connectivity; }
+    const VisibilityEngine& getVisibility() const { return visibility; }
+
+    // 切换怪物 AI；第一次切到 Scent 时才建立气味 / 噪音场
+    void setAiDriver(AiDriver driver);
+    AiDriver getAiDriver() const { return aiDriver; }
+    const ScentField& getScent() const { return scent; }
+    const ScentField& getNoise() const { return noise; }
+
+    // 可选：怪物很多时，批量视线检测分到这个线程池上并行（池子由调用方持有）
+    void setWorkerPool(WorkStealingPool* pool) { workers = pool; }
+
 private:
     std::vector<std::string> map;    // 地图
     int width = 0;
@@ -35,21 +99,109 @@ private:
 
     std::vector<Entity> entities;   
 
+    // 实体的分块索引：移动时增量维护，增删时标记脏、渲染查询时懒重建。
+    // 复制 Game 时不复制（副本第一次查询时重建）
+    mutable TransientCache<EntityChunkIndex> entityIndex;
+
+    DungeonKind dungeonKind = DungeonKind::Rooms;
+    CaveOptions caveOptions;
+
+    // 可走格子的连通区域，生成地图时建立，setTile 时增量维护。
+    // 只依赖地图，复制 Game 时多个副本共享同一份，setTile 发现共享时才先拷一份再改
+    std::shared_ptr<ConnectivityIndex> connectivity = std::make_shared<ConnectivityIndex>();
+
+    // 所有观察者共享的遮挡图，怪物视线检测用
+    VisibilityEngine visibility;
+    int sightRadius = 8;
+    WorkStealingPool* workers = nullptr;
+
+    // 每局游戏自己的随机数发生器（不用全局 std::rand，多个 Game 可以并行跑）
+    std::mt19937 rng;
+
     // 视野与探索
     std::vector<std::vector<bool>> visible;
     std::vector<std::vector<bool>> explored;
     int fovRadius = 8;
+    TileRect fovBox;                 // 上一次视野的外接矩形，下次只清这一块
+
+    // 探索进度和小地图金字塔，格子第一次被看到时增量更新
+    ExplorationMap exploration;
 
     std::vector<InventoryItem> inventory;
 
+    // 协同寻路向前规划的步数
+    int coopWindow = 8;
+
+    // AI 寻路预算：距离场最多展开的格子数，以及远处怪物单次寻路的预算，
+    // 让大地图上一回合的最坏耗时有上限
+    int aiNodeBudget = 4096;
+    PathOptions farPathOptions = { 512, 0, true };
+
+    // 每回合重建的 AI 临时数据，复制 Game 时不复制
+    struct AiScratch {
+        ReservationTable reservations;   // 怪物之间的时空预约表
+        std::vector<int> distance;       // 每回合复用的距离场缓冲区
+        std::vector<int> frontier;
+        std::vector<std::size_t> active; // 本回合和玩家在同一区域的活怪物
+        std::vector<LosQuery> queries;   // 当前一片的视线查询
+        std::vector<std::size_t> watchers;
+        std::vector<char> seen;
+    };
+    TransientCache<AiScratch> ai;
+
+    // 气味驱动：玩家每回合在脚下留气味，打斗在玩家位置制造噪音。
+    // 气味扩散慢、留得久，怪物顺着它找到玩家；噪音传得快、散得也快，
+    // 两者都能叫醒还没发现玩家的怪物。
+    // 一次留下的气味大约 35 回合后衰减到 epsilon 以下（原地站久了约 60 回合），
+    // 活跃格子只是玩家最近几十步走过的一条带子
+    AiDriver aiDriver = AiDriver::Cooperative;
+    ScentField scent{ ScentParams{ 0.2f, 0.95f, 1e-3f, 1 } };
+    ScentField noise{ ScentParams{ 0.25f, 0.9f, 1e-3f, 8 } };
+    static constexpr float SCENT_DEPOSIT = 1.0f;
+    static constexpr float NOISE_DEPOSIT = 100.0f;
+    static constexpr float SCENT_WAKE_THRESHOLD = 0.02f;
+
+    // 进行中的怪物回合，按阶段分片执行。
+    // AI 临时数据不随 Game 复制，所以回合进行中不要复制 Game
+    enum class TurnPhase {
+        Collect,        // 找出和玩家同一区域的活怪物
+        Perceive,       // 批量视线检测
+        Wake,           // 气味 / 噪音叫醒，排出行动列表
+        Plan,           // 距离场、排序、清空预约表
+        ReserveIdle,    // 没醒的怪物占住自己的格子
+        ReserveOrder,   // 要行动的怪物先占住当前格子
+        Act,            // 逐只寻路、移动、攻击
+        Done
+    };
+    static constexpr std::size_t TURN_SLICE = 256;   // 每片最多处理的对象数
+    // 视线检测每片最多攒的查询数。单条视线很便宜（超出视距直接返回），
+    // 批次要比 VisibilityEngine 的并行门槛大得多，线程池才分得出足够多的块
+    static constexpr std::size_t PERCEIVE_SLICE = 4096;
+
+    std::vector<std::size_t> turnOrder;  // 本回合要行动的怪物（已按规划顺序排好）
+    TurnPhase turnPhase = TurnPhase::Done;
+    std::size_t turnCursor = 0;          // 当前阶段处理到哪里
+    bool turnPending = false;
+
     // 简单日志系统
     std::vector<std::string> logLines;
 
-    void init();                     // 初始化整个游戏（调用地牢生成等）
-    void generateDungeon();          // 程序化地牢生成
+    void init(unsigned int seed);    // 初始化整个游戏（调用地牢生成等）
+    int randInt(int lo, int hi);     // [lo, hi] 均匀随机整数
+    void generateDungeon();          // 程序化地牢生成（按 dungeonKind 选择生成器）
+    void generateRooms();            // 房间 + 走廊
+    void generateCaves();            // 细胞自动机洞穴
     void updateFov();                // 计算 FoV
     void addLog(const std::string&); // 向日志里添加一条信息
 
+    void actMonster(std::size_t i, bool& running);
+    void monsterAttack(Entity& monster, bool& running);
+    void makeNoise(int x, int y);
+    void runTurnSlice(bool& running);
+    void planCooperativeTurn();
+    void planScentTurn();
+    void actMonsterScent(std::size_t i, bool& running);
+
     void pickUp();
     void useFirstItem();
 };
@@ -1,28 +1,33 @@
 #include "raylib.h"
 #include "game.hpp"
+#include "tile.hpp"
+#include "speculation.hpp"
+#include "viewport.hpp"
+#include "work_stealing_pool.hpp"
 #include <ctime>
-#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
 
 const int TILE_SIZE = 32;
+const int HUD_HEIGHT = 100;
+
+// 默认窗口大小；地图比窗口大时相机跟随玩家，窗口可以拖动改变大小
+const int DEFAULT_SCREEN_WIDTH  = 1280;
+const int DEFAULT_SCREEN_HEIGHT = 720;
+
+// 每帧留给怪物 AI 的时间；一回合算不完就分到后面几帧，画面不会卡住
+const std::chrono::microseconds AI_FRAME_BUDGET(4000);
 
 Color TileColor(char tile, bool visible, bool explored) {
     if (!visible && !explored) {
         return BLACK;
     }
 
-    if (!visible && explored) {
-        switch(tile) {
-            case '#': return (Color) {40, 40, 40, 255};
-            case '.': return (Color) {30, 30, 30, 255};
-            default: return (Color) {60, 60, 60, 255};
-        }
-    }
-
-    switch (tile) {
-        case '#': return (Color){ 130, 130, 130, 255 }; 
-        case '.': return (Color){ 60, 60, 60, 255 };     
-        default:  return (Color){ 100, 100, 100, 255 };
-    }
+    const TileTraits& traits = tile_traits(tile);
+    TileRgb rgb = visible ? traits.litColor : traits.darkColor;
+    return (Color){ rgb.r, rgb.g, rgb.b, 255 };
 }
 
 // 实体颜色
@@ -31,7 +36,7 @@ Color EntityColor(const Entity& e, bool visible) {
         return (Color){ 80, 80, 80, 255 };
     }
 
-    if (e.isPlayer) {
+    if (e.type == EntityType::Player) {
         return GREEN;
     } else if (e.hp > 0) {
         return RED;
@@ -41,25 +46,115 @@ Color EntityColor(const Entity& e, bool visible) {
     }
 }
 
-int main() {
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
+// 小地图：右上角，从探索金字塔里挑一层放得下的来画，和地图大小无关
+const int MINIMAP_MAX_WIDTH  = 200;
+const int MINIMAP_MAX_HEIGHT = 120;
+const int MINIMAP_MARGIN     = 10;
+
+void DrawMinimap(const Game& game, const TileRect& view, int screenWidth) {
+    const ExplorationMap& exploration = game.getExploration();
+    if (exploration.levelCount() == 0) return;
+
+    const ExplorationMap::Level& lv =
+        exploration.level(exploration.levelFor(MINIMAP_MAX_WIDTH, MINIMAP_MAX_HEIGHT));
+    int px = std::max(1, std::min(MINIMAP_MAX_WIDTH / lv.width, MINIMAP_MAX_HEIGHT / lv.height));
+    int ox = screenWidth - lv.width * px - MINIMAP_MARGIN;
+    int oy = MINIMAP_MARGIN;
+
+    DrawRectangle(ox, oy, lv.width * px, lv.height * px, (Color){ 0, 0, 0, 180 });
+
+    int cellArea = lv.cellSize * lv.cellSize;
+    for (int cy = 0; cy < lv.height; ++cy) {
+        for (int cx = 0; cx < lv.width; ++cx) {
+            std::size_t idx = static_cast<std::size_t>(cy) * lv.width + cx;
+            std::uint32_t seen = lv.explored[idx];
+            if (seen == 0) continue;
+
+            // 已探索的越多越亮，可走格子占多数的单元偏地板色
+            int bright = 60 + static_cast<int>(140 * seen / cellArea);
+            bool floorish = lv.exploredWalkable[idx] * 2 >= seen;
+            unsigned char b = static_cast<unsigned char>(std::min(bright, 255));
+            Color c = floorish ? (Color){ b, b, b, 255 }
+                               : (Color){ static_cast<unsigned char>(b / 2),
+                                          static_cast<unsigned char>(b / 2),
+                                          static_cast<unsigned char>(b * 3 / 4), 255 };
+            DrawRectangle(ox + cx * px, oy + cy * px, px, px, c);
+        }
+    }
+
+    // 玩家位置和当前视口范围
+    const Entity& player = game.getEntities()[0];
+    DrawRectangle(ox + player.x / lv.cellSize * px, oy + player.y / lv.cellSize * px, px, px, GREEN);
+    DrawRectangleLines(ox + view.x0 / lv.cellSize * px, oy + view.y0 / lv.cellSize * px,
+                       (view.x1 - view.x0 + lv.cellSize - 1) / lv.cellSize * px,
+                       (view.y1 - view.y0 + lv.cellSize - 1) / lv.cellSize * px, YELLOW);
+}
+
+int main(int argc, char** argv) {
+    // --caves：用细胞自动机洞穴代替房间 + 走廊
+    // --scent：怪物沿气味 / 噪音场追踪，代替协同 A*
+    // --cave-size WxH：洞穴尺寸（同时打开 --caves），比如 1024x1024
+    DungeonKind kind = DungeonKind::Rooms;
+    AiDriver driver = AiDriver::Cooperative;
+    CaveOptions caves;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--caves") == 0) kind = DungeonKind::Caves;
+        if (std::strcmp(argv[i], "--scent") == 0) driver = AiDriver::Scent;
+        if (std::strcmp(argv[i], "--cave-size") == 0 && i + 1 < argc) {
+            int w = 0, h = 0;
+            if (std::sscanf(argv[++i], "%dx%d", &w, &h) == 2 && w >= 16 && h >= 16) {
+                caves.width  = w;
+                caves.height = h;
+                kind = DungeonKind::Caves;
+            }
+        }
+    }
+
+    // 大洞穴按行块在这个池子上并行生成；之后怪物的批量视线检测也分到它上面。
+    // 推测出来的 Game 快照也会用到它，所以要在 game 和 speculator 之前构造、之后析构
+    WorkStealingPool pool;
+    caves.pool = &pool;
 
-    Game game;
+    Game game(static_cast<unsigned int>(std::time(nullptr)), kind, caves);
+    game.setAiDriver(driver);
+    game.setWorkerPool(&pool);
 
-    const auto& map = game.getMap();
-    int mapHeight = (int)map.size();
-    int mapWidth = mapHeight > 0 ? (int)map[0].size() : 0;
+    int mapWidth  = game.getWidth();
+    int mapHeight = game.getHeight();
 
-    int screenWidth = mapWidth * TILE_SIZE;
-    int screenHeight = mapHeight * TILE_SIZE + 100;
+    // 小地图直接按原大小开窗口，大地图开默认大小
+    int screenWidth  = std::min(mapWidth * TILE_SIZE, DEFAULT_SCREEN_WIDTH);
+    int screenHeight = std::min(mapHeight * TILE_SIZE, DEFAULT_SCREEN_HEIGHT - HUD_HEIGHT) + HUD_HEIGHT;
 
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     InitWindow(screenWidth, screenHeight, "ROGUE ENGINE");
     SetTargetFPS(60);
 
+    // 鼠标滚轮或 +/- 缩放
+    Viewport camera(screenWidth, screenHeight - HUD_HEIGHT, TILE_SIZE);
+    std::vector<std::size_t> inView;
+
     bool running = true;
 
+    // 空闲帧里在后台预算 WASD 四种走法的下一回合
+    TurnSpeculator speculator;
+    bool needSpeculation = true;
+
     while (!WindowShouldClose() && running) {
 
+        if (needSpeculation) {
+            speculator.speculate(game, "wasd");
+            needSpeculation = false;
+        }
+
+        // 上一回合的怪物还没走完：先在本帧预算内接着算，这期间不接受移动输入
+        if (game.monsterTurnPending()) {
+            if (game.stepMonsterTurn(running, AI_FRAME_BUDGET)) {
+                needSpeculation = true;
+            }
+            if (!running) break;
+        }
+
         int dx = 0, dy = 0;
 
         if (IsKeyPressed(KEY_W) || IsKeyPressed(KEY_UP))    dy = -1;
@@ -71,12 +166,34 @@ int main() {
             running = false;
         }
 
-        if (dx != 0 || dy != 0) {
-            game.stepPlayerMove(dx, dy, running);
+        float wheel = GetMouseWheelMove();
+        if (IsKeyPressed(KEY_EQUAL) || IsKeyPressed(KEY_KP_ADD))      wheel += 1.0f;
+        if (IsKeyPressed(KEY_MINUS) || IsKeyPressed(KEY_KP_SUBTRACT)) wheel -= 1.0f;
+        if (wheel > 0.0f) camera.zoomBy(1.25f);
+        if (wheel < 0.0f) camera.zoomBy(0.8f);
+
+        if ((dx != 0 || dy != 0) && !game.monsterTurnPending()) {
+            // 单方向移动对应 WASD，可以直接用推测结果
+            char command = 0;
+            if      (dx == 0 && dy == -1) command = 'w';
+            else if (dx == 0 && dy == 1)  command = 's';
+            else if (dx == -1 && dy == 0) command = 'a';
+            else if (dx == 1 && dy == 0)  command = 'd';
+
+            // 只拿已经算完的推测结果；还在后台算的话不等，自己分帧算这一回合
+            if (command == 0 || !speculator.tryCommit(command, game, running)) {
+                speculator.cancel();
+                game.stepPlayerMove(dx, dy, running);
+                if (!running) break;
+
+                // 怪物回合分帧执行，这一帧先用掉自己的预算
+                game.beginMonsterTurn();
+                game.stepMonsterTurn(running, AI_FRAME_BUDGET);
+            }
             if (!running) break;
 
-            game.updateMonsters(running);
-            if (!running) break;
+            // 回合全部算完才开始推测下一回合
+            needSpeculation = !game.monsterTurnPending();
         }
 
         BeginDrawing();
@@ -87,19 +204,26 @@ int main() {
         const auto& visibleGrid = game.getVisible();
         const auto& exploredGrid= game.getExplored();
 
-        // 画地图 
-        for (int y = 0; y < mapHeight; ++y) {
-            for (int x = 0; x < mapWidth; ++x) {
+        int viewHeight = GetScreenHeight() - HUD_HEIGHT;
+        camera.setViewport(GetScreenWidth(), viewHeight);
+        camera.follow(entities[0].x, entities[0].y, mapWidth, mapHeight);
+        TileRect view = camera.visibleTiles();
+        int tp = camera.tilePixels();
+
+        // 画地图：只画视口里的格子
+        for (int y = view.y0; y < view.y1; ++y) {
+            for (int x = view.x0; x < view.x1; ++x) {
                 bool vis  = visibleGrid.empty()  ? true : visibleGrid[y][x];
                 bool expl = exploredGrid.empty() ? true : exploredGrid[y][x];
 
                 Color c = TileColor(mapRef[y][x], vis, expl);
-                DrawRectangle(x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE, c);
+                DrawRectangle(camera.screenX(x), camera.screenY(y), tp, tp, c);
             }
         }
 
-        // 画实体
-        for (std::size_t i = 0; i < entities.size(); ++i) {
+        // 画实体：只取视口里的
+        game.entitiesIn(view, inView);
+        for (std::size_t i : inView) {
             const Entity& e = entities[i];
             if (e.hp <= 0 && e.glyph != 'x') continue;
 
@@ -109,21 +233,31 @@ int main() {
             bool vis = visibleGrid.empty() ? true : visibleGrid[y][x];
             Color c = EntityColor(e, vis);
 
-            int cx = x * TILE_SIZE + TILE_SIZE / 4;
-            int cy = y * TILE_SIZE + TILE_SIZE / 4;
-            int size = TILE_SIZE / 2;
+            int cx = camera.screenX(x) + tp / 4;
+            int cy = camera.screenY(y) + tp / 4;
+            int size = std::max(1, tp / 2);
 
             DrawRectangle(cx, cy, size, size, c);
         }
 
+        // HUD 区域盖住视口下方露出来的半格
+        DrawRectangle(0, viewHeight, GetScreenWidth(), HUD_HEIGHT, BLACK);
+
+        DrawMinimap(game, view, GetScreenWidth());
+
         const auto& ents = game.getEntities();
         if (!ents.empty()) {
             const Entity& player = ents[0];
-            DrawText(TextFormat("HP: %d / %d", player.hp, player.maxHp),
-                     10, mapHeight * TILE_SIZE + 10, 20, RAYWHITE);
+            DrawText(TextFormat("HP: %d / %d", player.hp, proto_of(player).maxHp),
+                     10, viewHeight + 10, 20, RAYWHITE);
+
+            const ExplorationMap& exploration = game.getExploration();
+            DrawText(TextFormat("Explored: %d%% (+%d)", exploration.percentExplored(),
+                                exploration.revealedThisTurn()),
+                     200, viewHeight + 10, 20, RAYWHITE);
         }
 
-        int logY = mapHeight * TILE_SIZE + 40;
+        int logY = viewHeight + 40;
         const auto& logs = game.getLog();
         int maxLinesToShow = 4;
         int start = (int)logs.size() - maxLinesToShow;
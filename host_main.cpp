@@ -0,0 +1,139 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <thread>
+
+#include "session_host.hpp"
+
+// 无界面多会话宿主。
+//
+// 用法：host [会话数] [线程数] [命令管道路径]
+// 不给管道路径时从标准输入读命令（可以用管道接到 bot 程序上），
+// 给了路径时从该文件 / 命名管道（mkfifo）读，作为本地版的“服务器”。
+//
+// 协议：每行一条命令，回复一行，以 "ok" 或 "err" 开头
+//   <id> <keys>     给会话 id 排队按键，比如 "3 wwd"
+//   all <keys>      给所有会话排队按键
+//   step            并行执行所有排队的按键
+//   bot <rounds>    每轮给每个会话一个随机移动并执行，共 rounds 轮
+//   state <id>      查看会话状态
+//   restart <id>    重新开一局
+//   stats           吞吐量与延迟统计
+//   reset-stats     清空统计
+//   quit            退出
+
+static void print_stats(const SessionHost& host, std::ostream& out) {
+    HostStats st = host.stats();
+    out << "ok sessions=" << st.sessions
+        << " running=" << st.running
+        << " turns=" << st.turns
+        << " sessions/sec=" << st.sessionsPerSecond
+        << " turns/sec=" << st.turnsPerSecond
+        << " p50_us=" << st.p50Micros
+        << " p99_us=" << st.p99Micros << "\n";
+}
+
+static void print_state(const SessionHost& host, std::size_t id, std::ostream& out) {
+    const Game& game = host.game(id);
+    const auto& entities = game.getEntities();
+    const auto& log = game.getLog();
+
+    out << "ok id=" << id << " running=" << (host.isRunning(id) ? 1 : 0);
+    if (!entities.empty()) {
+        const Entity& player = entities[0];
+        out << " x=" << player.x << " y=" << player.y
+            << " hp=" << player.hp << "/" << proto_of(player).maxHp;
+    }
+    if (!log.empty()) {
+        out << " log=\"" << log.back() << "\"";
+    }
+    out << "\n";
+}
+
+static bool parse_index(const std::string& word, std::size_t limit, std::size_t& out) {
+    char* end = nullptr;
+    unsigned long v = std::strtoul(word.c_str(), &end, 10);
+    if (word.empty() || *end != '\0' || v >= limit) return false;
+    out = static_cast<std::size_t>(v);
+    return true;
+}
+
+static void serve(SessionHost& host, std::istream& in, std::ostream& out) {
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream words(line);
+        std::string cmd;
+        if (!(words >> cmd)) continue;
+
+        if (cmd == "quit") {
+            out << "ok bye\n";
+            break;
+        } else if (cmd == "step") {
+            out << "ok turns=" << host.step() << "\n";
+        } else if (cmd == "bot") {
+            int rounds = 1;
+            words >> rounds;
+            std::size_t turns = 0;
+            for (int r = 0; r < rounds; ++r) {
+                host.enqueueBotMoves();
+                turns += host.step();
+            }
+            out << "ok turns=" << turns << "\n";
+        } else if (cmd == "stats") {
+            print_stats(host, out);
+        } else if (cmd == "reset-stats") {
+            host.resetStats();
+            out << "ok\n";
+        } else if (cmd == "state" || cmd == "restart") {
+            std::string arg;
+            std::size_t id = 0;
+            if (!(words >> arg) || !parse_index(arg, host.size(), id)) {
+                out << "err bad session id\n";
+            } else if (cmd == "state") {
+                print_state(host, id, out);
+            } else {
+                host.restart(id);
+                out << "ok\n";
+            }
+        } else {
+            std::string keys;
+            words >> keys;
+            std::size_t id = 0;
+            if (cmd == "all") {
+                for (std::size_t i = 0; i < host.size(); ++i) {
+                    for (char k : keys) host.enqueue(i, k);
+                }
+                out << "ok\n";
+            } else if (parse_index(cmd, host.size(), id)) {
+                for (char k : keys) host.enqueue(id, k);
+                out << "ok\n";
+            } else {
+                out << "err unknown command\n";
+            }
+        }
+        out.flush();
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t sessions = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    unsigned threads = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10))
+                                : std::thread::hardware_concurrency();
+    if (sessions == 0) sessions = 1;
+
+    SessionHost host(sessions, threads, 12345u);
+
+    if (argc > 3) {
+        std::ifstream pipe(argv[3]);
+        if (!pipe) {
+            std::cerr << "cannot open " << argv[3] << "\n";
+            return 1;
+        }
+        serve(host, pipe, std::cout);
+    } else {
+        serve(host, std::cin, std::cout);
+    }
+    return 0;
+}
@@ -1,10 +1,18 @@
 #include <iostream>
 #include <ctime>
-#include <cstdlib>
+#include <cstring>
+#include <cstdio>
 
 #include <conio.h>  // _getch
 
 #include "game.hpp"
+#include "speculation.hpp"
+#include "viewport.hpp"
+#include "work_stealing_pool.hpp"
+
+// 命令行视口大小（字符），地图比这个大时跟随玩家滚动
+const int CONSOLE_VIEW_WIDTH  = 80;
+const int CONSOLE_VIEW_HEIGHT = 20;
 
 
 char get_input() {
@@ -12,12 +20,41 @@ char get_input() {
     return static_cast<char>(ch);
 }
 
-int main() {
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
+int main(int argc, char** argv) {
+    // --caves：用细胞自动机洞穴代替房间 + 走廊
+    // --scent：怪物沿气味 / 噪音场追踪，代替协同 A*
+    // --cave-size WxH：洞穴尺寸（同时打开 --caves），比如 1024x1024
+    DungeonKind kind = DungeonKind::Rooms;
+    AiDriver driver = AiDriver::Cooperative;
+    CaveOptions caves;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--caves") == 0) kind = DungeonKind::Caves;
+        if (std::strcmp(argv[i], "--scent") == 0) driver = AiDriver::Scent;
+        if (std::strcmp(argv[i], "--cave-size") == 0 && i + 1 < argc) {
+            int w = 0, h = 0;
+            if (std::sscanf(argv[++i], "%dx%d", &w, &h) == 2 && w >= 16 && h >= 16) {
+                caves.width  = w;
+                caves.height = h;
+                kind = DungeonKind::Caves;
+            }
+        }
+    }
 
-    Game game;
+    // 大洞穴按行块并行生成；命令行版本只在生成时用池子，生成完就关掉
+    Game game = [&] {
+        WorkStealingPool pool;
+        caves.pool = &pool;
+        return Game(static_cast<unsigned int>(std::time(nullptr)), kind, caves);
+    }();
+    game.setAiDriver(driver);
     bool running = true;
 
+    // 等按键的时候在后台先把 WASD 四种走法的下一回合算好
+    TurnSpeculator speculator;
+
+    // 一个字符一格，不缩放
+    Viewport camera(CONSOLE_VIEW_WIDTH, CONSOLE_VIEW_HEIGHT, 1);
+
     // 初始先算一次视野
     // （因为我们的 Game::render 假设外面先调用过 updateFov；
     //   最简单的办法是在 Game 构造完成后让它自己算一次。
@@ -26,8 +63,16 @@ int main() {
     //   这里我们就靠每次输入之后都算来保证：第一帧可能全黑，动一下就好了。
 
     while (running) {
-        game.render();
+        const Entity& player = game.getEntities()[0];
+        camera.follow(player.x, player.y, game.getWidth(), game.getHeight());
+        game.render(camera);
+        speculator.speculate(game, "wasd");
+
         char command = get_input();
+        if (speculator.commit(command, game, running)) {
+            continue; // 命中：玩家和怪物这一回合都已经算完
+        }
+
         game.handleInput(command, running);
         if (!running) break;
         
@@ -1,6 +1,6 @@
 #include "pathfinding.hpp"
+#include "tile.hpp"
 #include <queue>
-#include <unordered_map>
 #include <limits>
 #include <algorithm> // std::reverse
 
@@ -14,123 +14,431 @@ static std::pair<int,int> fromIndex(int idx, int width) {
     return { idx % width, idx / width };
 }
 
-// 判断地图格子是否可通行（只看地图，不看实体）
-// 你可以根据自己的定义调整，这里假设 '.' 是可走的
+// 判断地图格子是否可通行（只看地图，不看实体），地形定义见 tile.hpp
 static bool is_walkable_tile_map_only(const std::vector<std::string>& map,
                                       int x, int y) {
     int height = static_cast<int>(map.size());
     int width  = static_cast<int>(map[0].size());
     if (x < 0 || x >= width || y < 0 || y >= height) return false;
-    return map[y][x] == '.';
+    return tile_walkable(map[y][x]);
 }
 
 Path find_path(const std::vector<std::string>& map,
                int sx, int sy,
                int tx, int ty) {
-    Path empty;
+    return find_path_with<FourWay, UniformCost, ManhattanHeuristic>(map, sx, sy, tx, ty);
+}
+
+Path find_path(const std::vector<std::string>& map,
+               const ConnectivityIndex& connectivity,
+               int sx, int sy,
+               int tx, int ty) {
+    if (!connectivity.connected(sx, sy, tx, ty)) return Path();
+    return find_path(map, sx, sy, tx, ty);
+}
+
+PathResult find_path(const std::vector<std::string>& map,
+                     int sx, int sy,
+                     int tx, int ty,
+                     const PathOptions& options) {
+    if (options.bidirectional) {
+        return find_path_bidirectional(map, sx, sy, tx, ty, options);
+    }
+    return find_path_bounded<FourWay, UniformCost, ManhattanHeuristic>(map, sx, sy, tx, ty, options);
+}
+
+// 双向 BFS 两边的缓冲区，按线程复用
+static path_detail::SearchScratch* bidirectional_scratch() {
+    thread_local path_detail::SearchScratch sides[2];
+    return sides;
+}
+
+void reserve_search_scratch(std::size_t cells) {
+    path_detail::search_scratch().begin(cells);
+    path_detail::SearchScratch* sides = bidirectional_scratch();
+    sides[0].begin(cells);
+    sides[1].begin(cells);
+}
+
+PathResult find_path_bidirectional(const std::vector<std::string>& map,
+                                   int sx, int sy,
+                                   int tx, int ty,
+                                   const PathOptions& options) {
+    PathResult result;
 
     int height = static_cast<int>(map.size());
-    if (height == 0) return empty;
+    if (height == 0) return result;
     int width  = static_cast<int>(map[0].size());
 
-    // 起点或终点本身不可走，直接无路可走
-    if (!is_walkable_tile_map_only(map, sx, sy) &&
-        !(sx == tx && sy == ty)) {
-        return empty;
-    }
-    if (!is_walkable_tile_map_only(map, tx, ty)) {
-        return empty;
+    if (!is_walkable_tile_map_only(map, sx, sy) && !(sx == tx && sy == ty)) return result;
+    if (!is_walkable_tile_map_only(map, tx, ty)) return result;
+
+    int startIdx = toIndex(sx, sy, width);
+    int goalIdx  = toIndex(tx, ty, width);
+    if (startIdx == goalIdx) {
+        result.path.push_back({ sx, sy });
+        result.complete = true;
+        return result;
     }
 
-    struct Node {
-        int idx;
-        int f; // f = g + h
+    // 两个方向各自的 BFS 状态：0 = 从起点出发，1 = 从终点出发。
+    // 缓冲区按线程复用，g 存步数
+    path_detail::SearchScratch* sides = bidirectional_scratch();
+    const std::size_t cells = static_cast<std::size_t>(width) * height;
+    sides[0].begin(cells);
+    sides[1].begin(cells);
+    sides[0].visit(startIdx, 0, -1);
+    sides[1].visit(goalIdx, 0, -1);
+    std::vector<int> layer[2] = { { startIdx }, { goalIdx } };
+
+    const int dirs[4][2] = {
+        { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }
     };
 
-    auto heuristic = [=](int x, int y) {
-        // 曼哈顿距离
+    path_detail::SearchBudget budget(options);
+    int meet = -1;
+    int bestTotal = std::numeric_limits<int>::max();
+    int bestForward = startIdx; // 预算用完时，正向已探索里离终点最近的格子
+    auto closeness = [&](int idx) {
+        auto [x, y] = fromIndex(idx, width);
         return std::abs(x - tx) + std::abs(y - ty);
     };
 
-    // open list：用最小堆按 f 排序
-    struct NodeCmp {
-        bool operator()(const Node& a, const Node& b) const {
-            return a.f > b.f; // 小顶堆
+    bool outOfBudget = false;
+    while (!layer[0].empty() && !layer[1].empty() && meet == -1 && !outOfBudget) {
+        // 展开较小的一层
+        int side  = layer[0].size() <= layer[1].size() ? 0 : 1;
+        int other = 1 - side;
+
+        std::vector<int> next;
+        for (int idx : layer[side]) {
+            if (budget.exhausted(result.expanded)) {
+                outOfBudget = true;
+                break;
+            }
+            ++result.expanded;
+
+            auto [cx, cy] = fromIndex(idx, width);
+            for (auto& d : dirs) {
+                int nx = cx + d[0];
+                int ny = cy + d[1];
+                if (!is_walkable_tile_map_only(map, nx, ny)) continue;
+
+                int nIdx = toIndex(nx, ny, width);
+                if (sides[side].seen(nIdx)) continue;
+                sides[side].visit(nIdx, sides[side].g[idx] + 1, idx);
+                next.push_back(nIdx);
+
+                if (side == 0 && closeness(nIdx) < closeness(bestForward)) {
+                    bestForward = nIdx;
+                }
+
+                // 碰到另一边已经到过的格子：这一层里取总长最短的相遇点
+                if (sides[other].seen(nIdx)) {
+                    int total = sides[0].g[nIdx] + sides[1].g[nIdx];
+                    if (total < bestTotal) {
+                        bestTotal = total;
+                        meet = nIdx;
+                    }
+                }
+            }
+        }
+        layer[side].swap(next);
+    }
+
+    if (meet != -1) {
+        // 起点 -> 相遇点
+        for (int idx = meet; idx != -1; idx = sides[0].parent[idx]) {
+            result.path.push_back(fromIndex(idx, width));
+        }
+        std::reverse(result.path.begin(), result.path.end());
+        // 相遇点 -> 终点
+        for (int idx = sides[1].parent[meet]; idx != -1; idx = sides[1].parent[idx]) {
+            result.path.push_back(fromIndex(idx, width));
+        }
+        result.complete = true;
+    } else if (outOfBudget) {
+        for (int idx = bestForward; idx != -1; idx = sides[0].parent[idx]) {
+            result.path.push_back(fromIndex(idx, width));
+        }
+        std::reverse(result.path.begin(), result.path.end());
+    }
+    return result;
+}
+
+// ------- 时空预约表 -------
+
+ReservationTable::ReservationTable(int width, int height, int depth) {
+    reset(width, height, depth);
+}
+
+void ReservationTable::reset(int width, int height, int depth) {
+    clear();
+    width_  = width;
+    height_ = height;
+    depth_  = depth;
+    if (slots_.empty()) {
+        slots_.assign(64, Slot{ 0, -1, 0 });
+    }
+}
+
+void ReservationTable::clear() {
+    // 换一代，旧槽全部失效；回绕时整体清零一次
+    if (++generation_ == 0) {
+        for (Slot& slot : slots_) slot.gen = 0;
+        generation_ = 1;
+    }
+    size_ = 0;
+}
+
+void ReservationTable::reserveSlots(std::size_t count) {
+    if (slots_.empty()) slots_.assign(64, Slot{ 0, -1, 0 });
+    while (count * 2 > slots_.size()) grow();
+}
+
+std::size_t ReservationTable::slotOf(long long key) const {
+    std::size_t mask = slots_.size() - 1;
+    std::size_t i = static_cast<std::size_t>(
+        (static_cast<unsigned long long>(key) * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while (slots_[i].gen == generation_ && slots_[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void ReservationTable::grow() {
+    // 容量翻倍，只搬本代还有人占着的键
+    std::vector<Slot> old;
+    old.swap(slots_);
+    slots_.assign(old.size() * 2, Slot{ 0, -1, 0 });
+    size_ = 0;
+
+    for (const Slot& slot : old) {
+        if (slot.gen != generation_ || slot.owner == -1) continue;
+        slots_[slotOf(slot.key)] = slot;
+        ++size_;
+    }
+}
+
+int ReservationTable::ownerAt(int x, int y, int t) const {
+    if (x < 0 || x >= width_ || y < 0 || y >= height_) return -1;
+    if (t < 0 || t > depth_ || slots_.empty()) return -1;
+    const Slot& slot = slots_[slotOf(keyOf(x, y, t))];
+    return slot.gen == generation_ ? slot.owner : -1;
+}
+
+void ReservationTable::reserve(int x, int y, int t, int agent) {
+    if (x < 0 || x >= width_ || y < 0 || y >= height_) return;
+    if (t < 0 || t > depth_) return;
+    if ((size_ + 1) * 2 > slots_.size()) grow();
+
+    long long key = keyOf(x, y, t);
+    Slot& slot = slots_[slotOf(key)];
+    if (slot.gen != generation_) {
+        slot.key = key;
+        slot.gen = generation_;
+        ++size_;
+    }
+    slot.owner = agent;
+}
+
+void ReservationTable::release(int x, int y, int t, int agent) {
+    if (ownerAt(x, y, t) != agent) return;
+    slots_[slotOf(keyOf(x, y, t))].owner = -1;
+}
+
+bool ReservationTable::conflicts(int agent, int x0, int y0, int x1, int y1, int t) const {
+    // 目标格在下一步已经被别人占了
+    int next = ownerAt(x1, y1, t + 1);
+    if (next != -1 && next != agent) return true;
+
+    // 对穿：别人这一步在 (x1, y1)，下一步要走到 (x0, y0)
+    int here  = ownerAt(x1, y1, t);
+    int there = ownerAt(x0, y0, t + 1);
+    return here != -1 && here != agent && here == there;
+}
+
+void ReservationTable::reservePath(const Path& path, int agent, bool holdEnd) {
+    if (path.empty()) return;
+    int len = static_cast<int>(path.size());
+    for (int t = 0; t < len && t <= depth_; ++t) {
+        reserve(path[t].first, path[t].second, t, agent);
+    }
+    if (holdEnd) {
+        for (int t = len; t <= depth_; ++t) {
+            reserve(path.back().first, path.back().second, t, agent);
         }
+    }
+}
+
+// ------- 距离场（反向 BFS） -------
+
+std::vector<int> distance_field(const std::vector<std::string>& map,
+                                int tx, int ty,
+                                int maxNodes) {
+    std::vector<int> dist;
+    std::vector<int> frontier;
+    distance_field(map, tx, ty, maxNodes, dist, frontier);
+    return dist;
+}
+
+void distance_field(const std::vector<std::string>& map,
+                    int tx, int ty,
+                    int maxNodes,
+                    std::vector<int>& dist,
+                    std::vector<int>& frontier) {
+    int height = static_cast<int>(map.size());
+    if (height == 0) {
+        dist.clear();
+        frontier.clear();
+        return;
+    }
+    int width  = static_cast<int>(map[0].size());
+
+    std::size_t cells = static_cast<std::size_t>(width) * height;
+    if (dist.size() != cells) {
+        dist.assign(cells, PATH_UNREACHABLE);
+    } else {
+        for (int idx : frontier) {
+            dist[idx] = PATH_UNREACHABLE;
+        }
+    }
+    frontier.clear();
+
+    if (!is_walkable_tile_map_only(map, tx, ty)) return;
+
+    int goalIdx = toIndex(tx, ty, width);
+    dist[goalIdx] = 0;
+    frontier.push_back(goalIdx);
+
+    const int dirs[4][2] = {
+        { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }
     };
 
-    std::priority_queue<Node, std::vector<Node>, NodeCmp> open;
-    std::unordered_map<int, int> cameFrom;         // child idx -> parent idx
-    std::unordered_map<int, int> gScore;           // idx -> g
-    const int INF = std::numeric_limits<int>::max();
+    // frontier 本身就是 BFS 队列，head 之前的都已经处理过。
+    // BFS 给格子写下的距离一旦写入就是最终值，所以提前停下不影响已写入的格子
+    std::size_t limit = maxNodes > 0 ? static_cast<std::size_t>(maxNodes) : dist.size();
+    for (std::size_t head = 0; head < frontier.size() && head < limit; ++head) {
+        int idx = frontier[head];
+        auto [cx, cy] = fromIndex(idx, width);
+
+        for (auto& d : dirs) {
+            int nx = cx + d[0];
+            int ny = cy + d[1];
+            if (!is_walkable_tile_map_only(map, nx, ny)) continue;
+
+            int nIdx = toIndex(nx, ny, width);
+            if (dist[nIdx] != PATH_UNREACHABLE) continue;
+
+            dist[nIdx] = dist[idx] + 1;
+            frontier.push_back(nIdx);
+        }
+    }
+}
+
+// ------- 时空窗口 A* -------
+
+Path find_path_cooperative(const std::vector<std::string>& map,
+                           const std::vector<int>& distToGoal,
+                           const ReservationTable& table,
+                           int agent,
+                           int sx, int sy,
+                           int tx, int ty) {
+    Path empty;
+
+    int height = static_cast<int>(map.size());
+    if (height == 0) return empty;
+    int width  = static_cast<int>(map[0].size());
+
+    if (!is_walkable_tile_map_only(map, sx, sy)) return empty;
 
     int startIdx = toIndex(sx, sy, width);
     int goalIdx  = toIndex(tx, ty, width);
+    if (distToGoal[startIdx] == PATH_UNREACHABLE) return empty;
 
-    gScore[startIdx] = 0;
-    open.push({ startIdx, heuristic(sx, sy) });
+    const int depth = table.depth();
 
-    auto get_g = [&](int idx) {
-        auto it = gScore.find(idx);
-        if (it == gScore.end()) return INF;
-        return it->second;
+    // 窗口只有 depth 步，能到达的状态都在以起点为中心、边长 2 * depth + 1 的
+    // 方框里。时空状态按方框内的局部坐标编号，直接用线程复用的平铺数组
+    // 记录 g / parent，不需要哈希表
+    const int side = 2 * depth + 1;
+    auto toState = [=](int x, int y, int t) {
+        return (t * side + (y - sy + depth)) * side + (x - sx + depth);
     };
+    auto stateX = [=](int state) { return state % side - depth + sx; };
+    auto stateY = [=](int state) { return (state / side) % side - depth + sy; };
+    auto stateT = [=](int state) { return state / (side * side); };
 
-    std::vector<bool> closed(width * height, false);
+    struct Node {
+        int state;
+        int f;
+        int g;
+    };
+
+    // f 相同时优先 g 大的（离目标更近），减少无意义的等待展开
+    struct NodeCmp {
+        bool operator()(const Node& a, const Node& b) const {
+            if (a.f != b.f) return a.f > b.f;
+            return a.g < b.g;
+        }
+    };
+
+    path_detail::SearchScratch& scratch = path_detail::search_scratch();
+    scratch.begin(static_cast<std::size_t>(side) * side * (depth + 1));
+    std::priority_queue<Node, std::vector<Node>, NodeCmp> open;
+
+    int startState = toState(sx, sy, 0);
+    scratch.visit(startState, 0, -1);
+    open.push({ startState, distToGoal[startIdx], 0 });
+
+    // 4 方向邻居 + 原地等待
+    const int moves[5][2] = {
+        { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }, { 0, 0 }
+    };
 
     while (!open.empty()) {
         Node current = open.top();
         open.pop();
 
-        if (closed[current.idx]) continue;
-        closed[current.idx] = true;
+        if (scratch.g[current.state] < current.g) continue; // 过期节点
+
+        int cx = stateX(current.state);
+        int cy = stateY(current.state);
+        int t  = stateT(current.state);
 
-        if (current.idx == goalIdx) {
-            // 找到目标，回溯路径
+        if (toIndex(cx, cy, width) == goalIdx || t >= depth) {
+            // 到达目标或者走满窗口，回溯时空路径
             Path path;
-            int idx = goalIdx;
-            while (true) {
-                auto [cx, cy] = fromIndex(idx, width);
-                path.push_back({cx, cy});
-                if (idx == startIdx) break;
-                idx = cameFrom[idx];
+            for (int state = current.state; state != -1; state = scratch.parent[state]) {
+                path.push_back({ stateX(state), stateY(state) });
             }
             std::reverse(path.begin(), path.end());
             return path;
         }
 
-        auto [cx, cy] = fromIndex(current.idx, width);
+        for (auto& m : moves) {
+            int nx = cx + m[0];
+            int ny = cy + m[1];
+            if (!is_walkable_tile_map_only(map, nx, ny)) continue;
 
-        // 4 方向邻居
-        const int dirs[4][2] = {
-            { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }
-        };
-
-        for (auto& d : dirs) {
-            int nx = cx + d[0];
-            int ny = cy + d[1];
+            int nIdx = toIndex(nx, ny, width);
+            if (distToGoal[nIdx] == PATH_UNREACHABLE) continue;
 
-            if (!is_walkable_tile_map_only(map, nx, ny) &&
-                !(nx == tx && ny == ty)) {
+            // 目标格（玩家位置）允许多只怪物同时“到达”，即同时攻击
+            if (nIdx != goalIdx && table.conflicts(agent, cx, cy, nx, ny, t)) {
                 continue;
             }
 
-            int nIdx = toIndex(nx, ny, width);
-            if (closed[nIdx]) continue;
-
-            int tentativeG = get_g(current.idx);
-            if (tentativeG == INF) continue;
-            tentativeG += 1; // 每步代价 1
+            int nState = toState(nx, ny, t + 1);
+            int tentativeG = current.g + 1; // 移动和等待代价都是 1
 
-            if (tentativeG < get_g(nIdx)) {
-                gScore[nIdx]   = tentativeG;
-                cameFrom[nIdx] = current.idx;
-                int f = tentativeG + heuristic(nx, ny);
-                open.push({ nIdx, f });
+            if (!scratch.seen(nState) || tentativeG < scratch.g[nState]) {
+                scratch.visit(nState, tentativeG, current.state);
+                open.push({ nState, tentativeG + distToGoal[nIdx], tentativeG });
             }
         }
     }
 
-    // 找不到路径
+    // 窗口内每一步都被堵死（连原地等待都不行）
     return empty;
 }
@@ -2,12 +2,404 @@
 #include <vector>
 #include <string>
 #include <utility>
+#include <queue>
+#include <limits>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include "tile.hpp"
+#include "connectivity.hpp"
 
 // 路径：一串 (x, y) 坐标
 using Path = std::vector<std::pair<int,int>>;
 
 // A* 寻路：从 (sx, sy) 到 (tx, ty)
+// 4 方向、每步代价相同、曼哈顿启发，即 find_path_with<FourWay, UniformCost, ManhattanHeuristic>
 // 如果找不到路径，返回空的 Path
 Path find_path(const std::vector<std::string>& map,
                int sx, int sy,
                int tx, int ty);
+
+// 同上，但先查连通区域索引：起点和终点不在同一区域时 O(1) 返回空 Path，
+// 不会把整个可达区域搜一遍
+Path find_path(const std::vector<std::string>& map,
+               const ConnectivityIndex& connectivity,
+               int sx, int sy,
+               int tx, int ty);
+
+// ------- 策略化 A* -------
+//
+// 连通方式、代价函数、启发函数都是模板参数，编译期确定，
+// 每个组合实例化出来都等价于手写的专用版本。
+// 代价统一放大 10 倍，直走 10、斜走 14，这样八方向也能用整数。
+
+// 连通方式：提供邻居方向和基础步长代价
+struct FourWay {
+    static constexpr int count = 4;
+    static constexpr int dirs[4][2] = {
+        { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }
+    };
+    static constexpr int step_cost(int /*dx*/, int /*dy*/) { return 10; }
+};
+
+struct EightWay {
+    static constexpr int count = 8;
+    static constexpr int dirs[8][2] = {
+        { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 },
+        { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 }
+    };
+    static constexpr int step_cost(int dx, int dy) { return (dx != 0 && dy != 0) ? 14 : 10; }
+};
+
+// 代价函数：走进格子 tile 的代价，base 是连通方式给出的步长代价
+struct UniformCost {
+    static constexpr int cost(char /*tile*/, int base) { return base; }
+};
+
+struct TerrainCost {
+    static constexpr int cost(char tile, int base) { return base * tile_move_cost(tile); }
+};
+
+// 启发函数：参数是到目标的 |dx|、|dy|，和代价同一尺度
+// 地形代价至少为 1，所以这些估计都不会高估
+struct ManhattanHeuristic {
+    static constexpr int estimate(int dx, int dy) { return 10 * (dx + dy); }
+};
+
+struct OctileHeuristic {
+    static constexpr int estimate(int dx, int dy) {
+        return 10 * (dx + dy) - 6 * (dx < dy ? dx : dy);
+    }
+};
+
+// 启发为 0 时 A* 退化为 Dijkstra
+struct ZeroHeuristic {
+    static constexpr int estimate(int /*dx*/, int /*dy*/) { return 0; }
+};
+
+namespace path_detail {
+
+inline bool walkable(const std::vector<std::string>& map, int width, int height, int x, int y) {
+    if (x < 0 || x >= width || y < 0 || y >= height) return false;
+    return tile_walkable(map[y][x]);
+}
+
+} // namespace path_detail
+
+// ------- 有预算的寻路 -------
+//
+// 限制一次查询最多展开多少节点 / 花多少时间，用完预算就返回
+// 通往“离目标最近的已探索格子”的部分路径，保证单次查询的最坏耗时可控。
+
+struct PathOptions {
+    int maxNodes = 0;            // 最多展开的节点数，0 表示不限
+    int maxMicros = 0;           // 最多耗时（微秒），0 表示不限
+    bool bidirectional = false;  // 双向搜索：起点终点同时向中间推进，适合长距离
+};
+
+struct PathResult {
+    Path path;              // complete 时到达目标；否则通往离目标最近的已探索格子
+    bool complete = false;
+    int expanded = 0;       // 实际展开的节点数
+};
+
+namespace path_detail {
+
+// 预算检查：节点数每次都查，时间每 256 个节点查一次（取时钟本身也有开销）
+class SearchBudget {
+public:
+    explicit SearchBudget(const PathOptions& options)
+        : maxNodes(options.maxNodes), maxMicros(options.maxMicros),
+          start(std::chrono::steady_clock::now()) {}
+
+    bool exhausted(int expanded) const {
+        if (maxNodes > 0 && expanded >= maxNodes) return true;
+        if (maxMicros > 0 && (expanded & 255) == 0 && expanded > 0) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() >= maxMicros;
+        }
+        return false;
+    }
+
+private:
+    int maxNodes;
+    int maxMicros;
+    std::chrono::steady_clock::time_point start;
+};
+
+// 每个线程复用的搜索缓冲区。用“代数”标记哪些格子属于本次搜索，
+// 每次查询不用重新分配和清空整张地图大小的数组，预算很小时开销也很小
+struct SearchScratch {
+    std::vector<unsigned> seenStamp;    // == generation 表示 g / parent 有效
+    std::vector<unsigned> closedStamp;  // == generation 表示已关闭
+    std::vector<int> g;
+    std::vector<int> parent;
+    unsigned generation = 0;
+
+    void begin(std::size_t cells) {
+        if (seenStamp.size() < cells) {
+            seenStamp.assign(cells, 0);
+            closedStamp.assign(cells, 0);
+            g.resize(cells);
+            parent.resize(cells);
+            generation = 0;
+        }
+        if (++generation == 0) { // 回绕：整体清零一次
+            std::fill(seenStamp.begin(), seenStamp.end(), 0);
+            std::fill(closedStamp.begin(), closedStamp.end(), 0);
+            generation = 1;
+        }
+    }
+
+    bool seen(int idx) const { return seenStamp[idx] == generation; }
+    bool closed(int idx) const { return closedStamp[idx] == generation; }
+    void close(int idx) { closedStamp[idx] = generation; }
+    void visit(int idx, int gValue, int parentIdx) {
+        seenStamp[idx] = generation;
+        g[idx] = gValue;
+        parent[idx] = parentIdx;
+    }
+};
+
+inline SearchScratch& search_scratch() {
+    thread_local SearchScratch scratch;
+    return scratch;
+}
+
+} // namespace path_detail
+
+// Bounded 为 false 时预算检查和部分路径的记录在编译期整个去掉，
+// find_path_with 的无预算查询和手写的专用 A* 一样紧凑
+template <typename Connectivity, typename CostFn, typename Heuristic, bool Bounded = true>
+PathResult find_path_bounded(const std::vector<std::string>& map,
+                             int sx, int sy,
+                             int tx, int ty,
+                             const PathOptions& options) {
+    PathResult result;
+
+    int height = static_cast<int>(map.size());
+    if (height == 0) return result;
+    int width  = static_cast<int>(map[0].size());
+
+    auto walkable = [&](int x, int y) {
+        return path_detail::walkable(map, width, height, x, y);
+    };
+
+    // 起点或终点本身不可走，直接无路可走
+    if (!walkable(sx, sy) && !(sx == tx && sy == ty)) return result;
+    if (!walkable(tx, ty)) return result;
+
+    auto heuristic = [=](int x, int y) {
+        return Heuristic::estimate(std::abs(x - tx), std::abs(y - ty));
+    };
+    // 部分路径按“到目标的距离”挑终点，和启发函数无关（Dijkstra 的启发恒为 0）
+    auto closeness = [=](int idx) {
+        return std::abs(idx % width - tx) + std::abs(idx / width - ty);
+    };
+
+    struct Node {
+        int idx;
+        int f; // f = g + h
+    };
+
+    struct NodeCmp {
+        bool operator()(const Node& a, const Node& b) const {
+            return a.f > b.f; // 小顶堆
+        }
+    };
+
+    // 平铺数组代替哈希表：按下标直接访问，数组在同一线程的多次查询间复用
+    path_detail::SearchScratch& scratch = path_detail::search_scratch();
+    scratch.begin(static_cast<std::size_t>(width) * height);
+    std::priority_queue<Node, std::vector<Node>, NodeCmp> open;
+
+    int startIdx = sy * width + sx;
+    int goalIdx  = ty * width + tx;
+    int bestIdx  = startIdx;
+
+    scratch.visit(startIdx, 0, -1);
+    open.push({ startIdx, heuristic(sx, sy) });
+
+    path_detail::SearchBudget budget(options);
+    bool outOfBudget = false;
+
+    auto trace = [&](int endIdx) {
+        Path path;
+        for (int idx = endIdx; idx != -1; idx = scratch.parent[idx]) {
+            path.push_back({ idx % width, idx / width });
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    };
+
+    while (!open.empty()) {
+        Node current = open.top();
+        open.pop();
+
+        if (scratch.closed(current.idx)) continue;
+        scratch.close(current.idx);
+
+        if (current.idx == goalIdx) {
+            // 找到目标，回溯路径
+            result.path = trace(goalIdx);
+            result.complete = true;
+            return result;
+        }
+
+        if constexpr (Bounded) {
+            if (closeness(current.idx) < closeness(bestIdx)) {
+                bestIdx = current.idx;
+            }
+
+            if (budget.exhausted(result.expanded)) {
+                outOfBudget = true;
+                break;
+            }
+        }
+        ++result.expanded;
+
+        int cx = current.idx % width;
+        int cy = current.idx / width;
+        int g  = scratch.g[current.idx];
+
+        for (int k = 0; k < Connectivity::count; ++k) {
+            int dx = Connectivity::dirs[k][0];
+            int dy = Connectivity::dirs[k][1];
+            int nx = cx + dx;
+            int ny = cy + dy;
+
+            if (!walkable(nx, ny)) continue;
+            // 斜走不能贴着墙角切过去
+            if (dx != 0 && dy != 0 && (!walkable(cx + dx, cy) || !walkable(cx, cy + dy))) {
+                continue;
+            }
+
+            int nIdx = ny * width + nx;
+            if (scratch.closed(nIdx)) continue;
+
+            int tentativeG = g + CostFn::cost(map[ny][nx], Connectivity::step_cost(dx, dy));
+            if (!scratch.seen(nIdx) || tentativeG < scratch.g[nIdx]) {
+                scratch.visit(nIdx, tentativeG, current.idx);
+                open.push({ nIdx, tentativeG + heuristic(nx, ny) });
+            }
+        }
+    }
+
+    // 搜完了还没到目标说明不可达，返回空；预算用完则返回部分路径
+    if (outOfBudget) {
+        result.path = trace(bestIdx);
+    }
+    return result;
+}
+
+template <typename Connectivity, typename CostFn, typename Heuristic>
+Path find_path_with(const std::vector<std::string>& map,
+                    int sx, int sy,
+                    int tx, int ty) {
+    return find_path_bounded<Connectivity, CostFn, Heuristic, false>(map, sx, sy, tx, ty, PathOptions()).path;
+}
+
+// 带预算的 4 方向寻路。options.bidirectional 为 true 时走双向 BFS
+// （每步代价相同时结果仍是最短路），否则是 find_path 同款的 A*
+PathResult find_path(const std::vector<std::string>& map,
+                     int sx, int sy,
+                     int tx, int ty,
+                     const PathOptions& options);
+
+// 双向 BFS：每轮展开两边中较小的那一层，两边相遇时拼出最短路
+PathResult find_path_bidirectional(const std::vector<std::string>& map,
+                                   int sx, int sy,
+                                   int tx, int ty,
+                                   const PathOptions& options);
+
+// 把当前线程的 A* / 双向 BFS 缓冲区预先扩到 cells 格。
+// 换地图后调用一次，第一次寻路就不用临时分配整张地图大小的数组
+void reserve_search_scratch(std::size_t cells);
+
+// ------- 协同寻路（Cooperative A*） -------
+//
+// 多个怪物在同一回合里依次规划，先规划的怪物把自己未来几步
+// 占用的格子写进“时空预约表”，后规划的怪物会绕开这些 (x, y, t)，
+// 这样就不会出现规划好的下一步被别的怪物堵住、整条 A* 白算的情况。
+
+// 时空预约表：记录第 t 步时格子 (x, y) 被哪个 agent 占用。
+// 每只怪物只预约窗口内的几格，所以用以 (格子, t) 为键的开放寻址哈希表存，
+// 内存和清空开销只和预约数量有关，和地图大小无关
+class ReservationTable {
+public:
+    ReservationTable() = default;
+    ReservationTable(int width, int height, int depth);
+
+    // 重新设置尺寸（会清空所有预约）
+    void reset(int width, int height, int depth);
+    // 清空所有预约：代数加一，O(1)
+    void clear();
+    // 预先扩容到能放下 count 个预约，回合中途就不用再扩
+    void reserveSlots(std::size_t count);
+
+    int depth() const { return depth_; }
+
+    // 返回占用者编号，没有人占用返回 -1
+    int ownerAt(int x, int y, int t) const;
+    void reserve(int x, int y, int t, int agent);
+    void release(int x, int y, int t, int agent);
+
+    // agent 在第 t 步从 (x0, y0) 走到 (x1, y1) 是否和别人冲突
+    // （目标格已被占用，或者和别人对穿）
+    bool conflicts(int agent, int x0, int y0, int x1, int y1, int t) const;
+
+    // 把一条时空路径（path[t] 是第 t 步的位置）写进预约表，
+    // 路径走完后如果还有剩余窗口，就一直占着终点
+    void reservePath(const Path& path, int agent, bool holdEnd);
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    int depth_ = 0;
+
+    struct Slot {
+        long long key;   // (y * width + x) * (depth + 1) + t
+        int owner;       // -1 表示预约已释放（键留着，线性探测不断链）
+        unsigned gen;    // 不等于 generation_ 的槽是空槽
+    };
+
+    std::vector<Slot> slots_;          // 容量为 2 的幂，装载率不超过一半
+    std::size_t size_ = 0;             // 本代用掉的槽数
+    unsigned generation_ = 1;
+
+    long long keyOf(int x, int y, int t) const {
+        return (static_cast<long long>(y) * width_ + x) * (depth_ + 1) + t;
+    }
+    // 键所在的槽；没有这个键时返回它应该放进去的空槽
+    std::size_t slotOf(long long key) const;
+    void grow();
+};
+
+// 从 (tx, ty) 出发做一次 BFS，得到每个格子到目标的真实步数（只看地图）
+// 到不了的格子为 PATH_UNREACHABLE；maxNodes > 0 时最多展开这么多格子，
+// 超出预算的远处格子也是 PATH_UNREACHABLE
+constexpr int PATH_UNREACHABLE = -1;
+std::vector<int> distance_field(const std::vector<std::string>& map,
+                                int tx, int ty,
+                                int maxNodes = 0);
+
+// 可复用版本：dist 和 frontier 由调用方持有、在多次调用之间复用。
+// 每次只把上一次写过的格子（就是上一次的 frontier）重置，
+// 所以有预算时单次开销只和展开的格子数有关，和地图大小无关
+void distance_field(const std::vector<std::string>& map,
+                    int tx, int ty,
+                    int maxNodes,
+                    std::vector<int>& dist,
+                    std::vector<int>& frontier);
+
+// 在时空里做窗口化 A*：
+// - 每一步可以走到 4 邻居或原地等待，代价都是 1
+// - 启发函数直接用 distance_field 的真实距离，所以搜索几乎是直线推进
+// - 到达 (tx, ty) 或者走满 table.depth() 步就结束
+// 返回 path[t] = 第 t 步的位置（path[0] 是起点）；无路可走返回空 Path
+Path find_path_cooperative(const std::vector<std::string>& map,
+                           const std::vector<int>& distToGoal,
+                           const ReservationTable& table,
+                           int agent,
+                           int sx, int sy,
+                           int tx, int ty);
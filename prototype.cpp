@@ -0,0 +1,127 @@
+#include "prototype.hpp"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+// 和 data/prototypes.txt 内容一致，找不到数据文件时使用
+static const char* BUILTIN_PROTOTYPES =
+    "player  player         @ 30 6 0  Player\n"
+    "monster goblin         g 12 4 0  Goblin\n"
+    "monster orc            o 12 4 0  Orc\n"
+    "item    healing_potion ! 0  0 10 Healing Potion\n";
+
+// 游戏逻辑直接用到的原型，数据文件里必须有，并且种类要对
+struct RequiredPrototype {
+    const char* id;
+    EntityType type;
+};
+
+static const RequiredPrototype REQUIRED_PROTOTYPES[] = {
+    { "player",         EntityType::Player  },
+    { "goblin",         EntityType::Monster },
+    { "orc",            EntityType::Monster },
+    { "healing_potion", EntityType::Item    }
+};
+
+static bool parse_kind(const std::string& word, EntityType& out) {
+    if (word == "player")  { out = EntityType::Player;  return true; }
+    if (word == "monster") { out = EntityType::Monster; return true; }
+    if (word == "item")    { out = EntityType::Item;    return true; }
+    return false;
+}
+
+bool PrototypeTable::load(std::istream& in, std::string* error) {
+    protos.clear();
+    byId.clear();
+
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        std::istringstream words(line);
+        std::string kind;
+        if (!(words >> kind) || kind[0] == '#') continue;
+
+        Prototype p;
+        std::string glyph;
+        if (!parse_kind(kind, p.type) ||
+            !(words >> p.id >> glyph >> p.maxHp >> p.attack >> p.healAmount) ||
+            glyph.size() != 1 ||
+            byId.count(p.id) != 0 ||
+            protos.size() >= INVALID_PROTO) {
+            if (error) *error = "bad prototype at line " + std::to_string(lineNo);
+            return false;
+        }
+        p.glyph = glyph[0];
+
+        std::getline(words >> std::ws, p.name);
+        if (p.name.empty()) p.name = p.id;
+
+        byId[p.id] = static_cast<ProtoId>(protos.size());
+        protos.push_back(std::move(p));
+    }
+    return true;
+}
+
+bool PrototypeTable::loadFile(const std::string& path, std::string* error) {
+    std::ifstream in(path);
+    if (!in) {
+        if (error) *error = "cannot open " + path;
+        return false;
+    }
+    return load(in, error);
+}
+
+ProtoId PrototypeTable::find(const std::string& id) const {
+    auto it = byId.find(id);
+    return it == byId.end() ? INVALID_PROTO : it->second;
+}
+
+static bool has_required(const PrototypeTable& table, std::string& error) {
+    for (const RequiredPrototype& req : REQUIRED_PROTOTYPES) {
+        ProtoId proto = table.find(req.id);
+        if (proto == INVALID_PROTO) {
+            error = std::string("missing prototype '") + req.id + "'";
+            return false;
+        }
+        if (table[proto].type != req.type) {
+            error = std::string("prototype '") + req.id + "' has the wrong kind";
+            return false;
+        }
+    }
+    return true;
+}
+
+const PrototypeTable& prototypes() {
+    // 函数内静态变量：只加载一次，多线程下初始化也是安全的
+    static const PrototypeTable table = [] {
+        PrototypeTable t;
+        std::string error;
+        if (t.loadFile("data/prototypes.txt", &error) && has_required(t, error)) {
+            return t;
+        }
+
+        // 数据文件有问题时要让人知道，不然改了数据没生效也看不出来
+        std::cerr << "data/prototypes.txt: " << error
+                  << "; using built-in prototypes\n";
+        std::istringstream builtin(BUILTIN_PROTOTYPES);
+        t.load(builtin);
+        return t;
+    }();
+    return table;
+}
+
+Entity make_entity(ProtoId proto, int x, int y) {
+    const Prototype& p = prototypes()[proto];
+
+    Entity e;
+    e.x      = x;
+    e.y      = y;
+    e.hp     = p.maxHp;
+    e.proto  = proto;
+    e.glyph  = p.glyph;
+    e.blocks = p.type != EntityType::Item;
+    e.type   = p.type;
+    e.alerted = false;
+    return e;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <istream>
+#include "entity.hpp"
+
+// 实体原型：同一种怪物 / 道具共享的、不会变的数据。
+// 实体和背包格子里只存 ProtoId，需要属性时查表。
+struct Prototype {
+    std::string id;      // 数据文件里的标识，比如 "goblin"
+    std::string name;    // 显示用名字，比如 "Goblin"
+    EntityType type;
+    char glyph;
+    int maxHp;
+    int attack;
+    int healAmount;
+};
+
+constexpr ProtoId INVALID_PROTO = static_cast<ProtoId>(-1);
+
+class PrototypeTable {
+public:
+    // 每行：kind id glyph hp atk heal name（name 可以带空格，# 开头为注释）
+    // 格式错误返回 false，并把出错的行号写进 error
+    bool load(std::istream& in, std::string* error = nullptr);
+    bool loadFile(const std::string& path, std::string* error = nullptr);
+
+    // 按标识查找，找不到返回 INVALID_PROTO
+    ProtoId find(const std::string& id) const;
+
+    const Prototype& operator[](ProtoId proto) const { return protos[proto]; }
+    std::size_t size() const { return protos.size(); }
+
+private:
+    std::vector<Prototype> protos;
+    std::unordered_map<std::string, ProtoId> byId;
+};
+
+// 全局原型表：第一次调用时加载 data/prototypes.txt，
+// 文件打不开、格式错误、缺少必需的原型或原型种类不对时，
+// 在 std::cerr 上报原因，然后退回内置的默认数据
+const PrototypeTable& prototypes();
+
+inline const Prototype& proto_of(const Entity& e) {
+    return prototypes()[e.proto];
+}
+
+// 按原型生成一个满血实体
+Entity make_entity(ProtoId proto, int x, int y);
@@ -0,0 +1,111 @@
+#include "scent.hpp"
+#include "tile.hpp"
+#include <algorithm>
+
+static const int DIRS[4][2] = {
+    { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }
+};
+
+void ScentField::build(const std::vector<std::string>& map) {
+    height = static_cast<int>(map.size());
+    width  = height > 0 ? static_cast<int>(map[0].size()) : 0;
+
+    std::size_t n = static_cast<std::size_t>(width) * height;
+    values.assign(n, 0.0f);
+    open.assign(n, 0);
+    active.clear();
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            open[static_cast<std::size_t>(y) * width + x] = tile_walkable(map[y][x]) ? 1 : 0;
+        }
+    }
+}
+
+void ScentField::onTileChanged(const std::vector<std::string>& map, int x, int y) {
+    if (x < 0 || x >= width || y < 0 || y >= height) return;
+    std::size_t idx = static_cast<std::size_t>(y) * width + x;
+    open[idx] = tile_walkable(map[y][x]) ? 1 : 0;
+    // 变成墙的格子里的气味直接丢掉；它留在活跃列表里，下一步算出 0 后自然移出
+    if (!open[idx]) values[idx] = 0.0f;
+}
+
+void ScentField::deposit(int x, int y, float amount) {
+    if (x < 0 || x >= width || y < 0 || y >= height) return;
+    std::size_t idx = static_cast<std::size_t>(y) * width + x;
+    if (!open[idx] || amount <= values[idx]) return;
+    if (values[idx] == 0.0f) active.push_back(static_cast<int>(idx));
+    values[idx] = amount;
+}
+
+void ScentField::advanceTurn() {
+    for (int i = 0; i < params.stepsPerTurn && !active.empty(); ++i) {
+        step();
+    }
+}
+
+void ScentField::step() {
+    std::vector<std::uint32_t>& mark = scratch->mark;
+    std::uint32_t& stamp = scratch->stamp;
+    std::vector<int>& candidates = scratch->candidates;
+    std::vector<float>& nextValues = scratch->nextValues;
+
+    if (mark.size() != values.size()) {
+        mark.assign(values.size(), 0);
+        stamp = 0;
+    }
+    // 标记溢出时整体清零重来（几十亿步才会发生一次）
+    if (++stamp == 0) {
+        std::fill(mark.begin(), mark.end(), 0);
+        stamp = 1;
+    }
+
+    // 活跃格子和它们的可走邻居，每个只算一次
+    candidates.clear();
+    for (int idx : active) {
+        if (mark[idx] != stamp) {
+            mark[idx] = stamp;
+            candidates.push_back(idx);
+        }
+        int x = idx % width;
+        int y = idx / width;
+        for (auto& d : DIRS) {
+            int nx = x + d[0];
+            int ny = y + d[1];
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height) continue;
+            int nIdx = ny * width + nx;
+            if (!open[nIdx] || mark[nIdx] == stamp) continue;
+            mark[nIdx] = stamp;
+            candidates.push_back(nIdx);
+        }
+    }
+
+    // v' = (v + k * Σ(邻居 - v)) * decay，只和可走邻居交换，墙边不漏
+    // 不在候选里的格子值都是 0，直接读 values 即可
+    nextValues.resize(candidates.size());
+    for (std::size_t k = 0; k < candidates.size(); ++k) {
+        int idx = candidates[k];
+        float v = open[idx] ? values[idx] : 0.0f;
+        float flow = 0.0f;
+        if (open[idx]) {
+            int x = idx % width;
+            int y = idx / width;
+            for (auto& d : DIRS) {
+                int nx = x + d[0];
+                int ny = y + d[1];
+                if (nx < 0 || nx >= width || ny < 0 || ny >= height) continue;
+                int nIdx = ny * width + nx;
+                if (!open[nIdx]) continue;
+                flow += values[nIdx] - v;
+            }
+        }
+        float nv = (v + params.diffusion * flow) * params.decay;
+        nextValues[k] = nv >= params.epsilon ? nv : 0.0f;
+    }
+
+    active.clear();
+    for (std::size_t k = 0; k < candidates.size(); ++k) {
+        values[candidates[k]] = nextValues[k];
+        if (nextValues[k] > 0.0f) active.push_back(candidates[k]);
+    }
+}
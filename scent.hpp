@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "transient.hpp"
+
+// 扩散参数
+struct ScentParams {
+    float diffusion = 0.2f;      // 每步向相邻格扩散的比例（<= 0.25 才稳定）
+    float decay = 0.98f;         // 每步整体衰减
+    float epsilon = 1e-3f;       // 低于这个值直接归零，格子退出活跃集合
+    int stepsPerTurn = 1;        // 每回合扩散几步（噪音传得比气味快）
+};
+
+// 气味 / 噪音扩散场：只在可走格子上扩散，墙会挡住。
+//
+// 大部分格子的值是 0，只维护值不为 0 的活跃格子：每一步只计算活跃格子
+// 和它们的邻居，衰减到 epsilon 以下的格子移出活跃集合，
+// 所以一步的代价只和最近事件周围的区域大小有关，和地图大小无关。
+class ScentField {
+public:
+    ScentField() = default;
+    explicit ScentField(const ScentParams& params) : params(params) {}
+
+    void build(const std::vector<std::string>& map);
+    // map[y][x] 已经改成新地形之后调用
+    void onTileChanged(const std::vector<std::string>& map, int x, int y);
+
+    bool built() const { return width > 0; }
+
+    // 在 (x, y) 留下强度为 amount 的气味 / 噪音（取较大值，不累加）
+    void deposit(int x, int y, float amount);
+
+    // 扩散并衰减 params.stepsPerTurn 步
+    void advanceTurn();
+
+    float value(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) return 0.0f;
+        return values[static_cast<std::size_t>(y) * width + x];
+    }
+
+    std::size_t activeCells() const { return active.size(); }
+
+private:
+    ScentParams params;
+    int width = 0;
+    int height = 0;
+    std::vector<float> values;
+    std::vector<char> open;              // 1 = 可走，气味能进来
+
+    std::vector<int> active;             // 值不为 0 的格子
+
+    // 每步的临时缓冲区，复制场时不复制，第一次扩散时按地图大小建
+    struct StepScratch {
+        std::vector<std::uint32_t> mark; // 去重用的代数标记
+        std::uint32_t stamp = 0;
+        std::vector<int> candidates;     // 这一步要计算的格子（活跃格子 + 邻居）
+        std::vector<float> nextValues;
+    };
+    TransientCache<StepScratch> scratch;
+
+    void step();
+};
@@ -0,0 +1,148 @@
+#include "session_host.hpp"
+#include <cmath>
+#include <algorithm>
+
+// ------- LatencyHistogram -------
+
+int LatencyHistogram::bucketOf(double micros) {
+    if (micros < 1.0) return 0;
+    int b = static_cast<int>(std::log2(micros) * SUB_BUCKETS) + 1;
+    return std::min(b, BUCKETS - 1);
+}
+
+double LatencyHistogram::upperBound(int bucket) {
+    return std::exp2(static_cast<double>(bucket) / SUB_BUCKETS);
+}
+
+void LatencyHistogram::record(double micros) {
+    ++buckets[bucketOf(micros)];
+    ++total;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKETS; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    total += other.total;
+}
+
+void LatencyHistogram::clear() {
+    std::fill(std::begin(buckets), std::end(buckets), 0);
+    total = 0;
+}
+
+double LatencyHistogram::percentile(double p) const {
+    if (total == 0) return 0.0;
+    auto rank = static_cast<std::uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total)));
+    rank = std::max<std::uint64_t>(rank, 1);
+
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return upperBound(i);
+    }
+    return upperBound(BUCKETS - 1);
+}
+
+// ------- SessionHost -------
+
+SessionHost::SessionHost(std::size_t sessionCount, unsigned threads, unsigned int seed)
+    : pool(threads), seeder(seed) {
+    sessions.reserve(sessionCount);
+    for (std::size_t i = 0; i < sessionCount; ++i) {
+        sessions.push_back(std::make_unique<Session>(seeder()));
+    }
+}
+
+void SessionHost::enqueue(std::size_t session, char command) {
+    if (session >= sessions.size()) return;
+    sessions[session]->pending.push_back(command);
+}
+
+void SessionHost::enqueueBotMoves() {
+    static const char moves[] = { 'w', 'a', 's', 'd' };
+    for (auto& s : sessions) {
+        if (!s->running) continue;
+        std::uniform_int_distribution<int> pick(0, 3);
+        s->pending.push_back(moves[pick(s->botRng)]);
+    }
+}
+
+// 与 main.cpp 的主循环一致：处理输入，然后怪物行动
+void SessionHost::runSession(Session& s) {
+    for (char command : s.pending) {
+        if (!s.running) break;
+
+        auto t0 = std::chrono::steady_clock::now();
+        s.game.handleInput(command, s.running);
+        if (s.running) {
+            s.game.updateMonsters(s.running);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+
+        s.latency.record(std::chrono::duration<double, std::micro>(t1 - t0).count());
+        ++s.turns;
+    }
+    s.pending.clear();
+}
+
+std::size_t SessionHost::step() {
+    std::vector<Session*> ready;
+    std::size_t turnsBefore = 0;
+    for (auto& s : sessions) {
+        turnsBefore += s->turns;
+        if (!s->pending.empty()) ready.push_back(s.get());
+    }
+    if (ready.empty()) return 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    pool.parallel_for(ready.size(), 1, [&ready](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            runSession(*ready[i]);
+        }
+    });
+    busy += std::chrono::steady_clock::now() - t0;
+    sessionSteps += ready.size();
+
+    std::size_t turnsAfter = 0;
+    for (auto& s : sessions) {
+        turnsAfter += s->turns;
+    }
+    return turnsAfter - turnsBefore;
+}
+
+void SessionHost::restart(std::size_t session) {
+    if (session >= sessions.size()) return;
+    sessions[session] = std::make_unique<Session>(seeder());
+}
+
+HostStats SessionHost::stats() const {
+    HostStats st;
+    st.sessions = sessions.size();
+    st.sessionSteps = sessionSteps;
+    st.seconds = std::chrono::duration<double>(busy).count();
+
+    LatencyHistogram all;
+    for (const auto& s : sessions) {
+        if (s->running) ++st.running;
+        st.turns += s->turns;
+        all.merge(s->latency);
+    }
+
+    if (st.seconds > 0.0) {
+        st.turnsPerSecond    = static_cast<double>(st.turns) / st.seconds;
+        st.sessionsPerSecond = static_cast<double>(st.sessionSteps) / st.seconds;
+    }
+    st.p50Micros = all.percentile(50.0);
+    st.p99Micros = all.percentile(99.0);
+    return st;
+}
+
+void SessionHost::resetStats() {
+    sessionSteps = 0;
+    busy = {};
+    for (auto& s : sessions) {
+        s->turns = 0;
+        s->latency.clear();
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "game.hpp"
+#include "work_stealing_pool.hpp"
+
+// 回合耗时直方图：按 log2 分桶（每个 2 的幂再细分 8 份），
+// 内存固定，长时间压测也不会越积越多
+class LatencyHistogram {
+public:
+    void record(double micros);
+    void merge(const LatencyHistogram& other);
+    void clear();
+
+    std::uint64_t count() const { return total; }
+    // 返回第 p 百分位（0~100）所在桶的上界，单位微秒
+    double percentile(double p) const;
+
+private:
+    static constexpr int SUB_BUCKETS = 8;
+    static constexpr int BUCKETS = 32 * SUB_BUCKETS; // 覆盖 1us ~ 2^32us
+    std::uint64_t buckets[BUCKETS] = {};
+    std::uint64_t total = 0;
+
+    static int bucketOf(double micros);
+    static double upperBound(int bucket);
+};
+
+struct HostStats {
+    std::size_t sessions = 0;        // 总会话数
+    std::size_t running = 0;         // 还没结束的会话数
+    std::uint64_t turns = 0;         // 执行过的回合数
+    std::uint64_t sessionSteps = 0;  // 被调度执行过的会话次数
+    double seconds = 0.0;            // step() 累计墙钟时间
+    double turnsPerSecond = 0.0;
+    double sessionsPerSecond = 0.0;
+    double p50Micros = 0.0;
+    double p99Micros = 0.0;
+};
+
+// 无界面的多会话宿主：一个进程里同时跑很多局 Game，
+// 命令先按会话排队，step() 时每个有命令的会话作为一个任务丢进工作窃取线程池
+class SessionHost {
+public:
+    SessionHost(std::size_t sessionCount, unsigned threads, unsigned int seed);
+
+    std::size_t size() const { return sessions.size(); }
+
+    void enqueue(std::size_t session, char command);
+    // 给每个还在运行的会话排一个随机移动（bot / 压测用）
+    void enqueueBotMoves();
+
+    // 并行执行所有排队的命令，返回本次执行的回合数
+    std::size_t step();
+
+    // 重新开一局（换一个新种子）
+    void restart(std::size_t session);
+
+    bool isRunning(std::size_t session) const { return sessions[session]->running; }
+    const Game& game(std::size_t session) const { return sessions[session]->game; }
+
+    HostStats stats() const;
+    void resetStats();
+
+private:
+    struct Session {
+        explicit Session(unsigned int seed) : game(seed), botRng(seed ^ 0x9e3779b9u) {}
+
+        Game game;
+        bool running = true;
+        std::vector<char> pending;     // 排队中的命令
+        std::mt19937 botRng;
+        std::uint64_t turns = 0;
+        LatencyHistogram latency;      // 只由执行该会话的任务写入
+    };
+
+    std::vector<std::unique_ptr<Session>> sessions;
+    WorkStealingPool pool;
+    std::mt19937 seeder;
+
+    std::uint64_t sessionSteps = 0;
+    std::chrono::steady_clock::duration busy{};
+
+    static void runSession(Session& s);
+};
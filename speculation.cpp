@@ -0,0 +1,118 @@
+#include "speculation.hpp"
+#include <algorithm>
+
+static char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+TurnSpeculator::TurnSpeculator() {
+    worker = std::thread([this] { workerLoop(); });
+}
+
+TurnSpeculator::~TurnSpeculator() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        invalidateLocked();
+    }
+    cv.notify_all();
+    worker.join();
+}
+
+void TurnSpeculator::invalidateLocked() {
+    ++generation;
+    base.reset();
+    queue.clear();
+    done.clear();
+}
+
+void TurnSpeculator::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    invalidateLocked();
+}
+
+void TurnSpeculator::speculate(const Game& game, const std::string& commands) {
+    // 快照在调用线程上复制：此时正空闲等待输入，不占关键路径
+    auto snapshot = std::make_shared<const Game>(game);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        invalidateLocked();
+        base = std::move(snapshot);
+        for (char c : commands) {
+            queue.push_back(to_lower(c));
+        }
+    }
+    cv.notify_all();
+}
+
+bool TurnSpeculator::commit(char command, Game& game, bool& running) {
+    return take(command, game, running, true);
+}
+
+bool TurnSpeculator::tryCommit(char command, Game& game, bool& running) {
+    return take(command, game, running, false);
+}
+
+bool TurnSpeculator::take(char command, Game& game, bool& running, bool wait) {
+    command = to_lower(command);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!base) return false;
+
+    // 正在算这个键：等它算完，总比从头再算一遍快
+    unsigned gen = generation;
+    if (wait) {
+        cv.wait(lock, [&] {
+            return inFlight != command || inFlightGeneration != gen || generation != gen;
+        });
+    }
+
+    auto it = std::find_if(done.begin(), done.end(),
+                           [command](const Outcome& o) { return o.command == command; });
+    if (generation != gen || it == done.end()) {
+        invalidateLocked();
+        return false;
+    }
+
+    game    = std::move(it->game);
+    running = it->running;
+    invalidateLocked();
+    return true;
+}
+
+void TurnSpeculator::workerLoop() {
+    while (true) {
+        std::shared_ptr<const Game> start;
+        char command = 0;
+        unsigned gen = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+
+            command = queue.front();
+            queue.erase(queue.begin());
+            start = base;
+            gen = generation;
+            inFlight = command;
+            inFlightGeneration = gen;
+        }
+
+        // 与 main.cpp 主循环里的一回合完全相同
+        Game next = *start;
+        bool running = true;
+        next.handleInput(command, running);
+        if (running) {
+            next.updateMonsters(running);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inFlight = 0;
+            if (gen == generation) {
+                done.push_back({ command, std::move(next), running });
+            }
+        }
+        cv.notify_all();
+    }
+}
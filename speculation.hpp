@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "game.hpp"
+
+// 推测执行：等待玩家按键的时候，后台线程把几个可能的按键
+// 各自的下一回合（玩家行动 + 怪物行动 + FoV）先算好。
+// 按键到达时如果命中，就直接把算好的 Game 换进来，
+// 关键路径上只剩一次 move，不用再等怪物 AI。
+//
+// Game 的随机数发生器在快照里，所以推测结果和现场计算完全一致。
+class TurnSpeculator {
+public:
+    TurnSpeculator();
+    ~TurnSpeculator();
+
+    TurnSpeculator(const TurnSpeculator&) = delete;
+    TurnSpeculator& operator=(const TurnSpeculator&) = delete;
+
+    // 以 base 当前状态为起点，按顺序在后台预算 commands 中每个按键的一回合。
+    // 之前未提交的推测全部作废。
+    void speculate(const Game& base, const std::string& commands);
+
+    // 玩家按下 command：命中（已算完或正在算这个键）就把结果换进 game 并返回 true，
+    // 这时玩家行动和怪物行动都已经完成；否则返回 false，调用方照常执行这一回合
+    bool commit(char command, Game& game, bool& running);
+
+    // 不等待的版本：只接受已经算完的结果，这个键还在算或者还没开始算都算未命中。
+    // 图形前端用它，未命中时自己分帧执行这一回合，渲染线程不会被后台的整回合卡住
+    bool tryCommit(char command, Game& game, bool& running);
+
+    // 作废所有推测
+    void cancel();
+
+private:
+    struct Outcome {
+        char command;
+        Game game;
+        bool running;
+    };
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+
+    unsigned generation = 0;               // 每次作废加一，过期的结果直接丢弃
+    std::shared_ptr<const Game> base;      // 当前推测的起点快照
+    std::string queue;                     // 还没开始算的按键
+    char inFlight = 0;                     // 正在算的按键
+    unsigned inFlightGeneration = 0;       // 正在算的按键属于哪一次推测
+    std::vector<Outcome> done;             // 已经算好的结果
+
+    void workerLoop();
+    void invalidateLocked();
+    bool take(char command, Game& game, bool& running, bool wait);
+};
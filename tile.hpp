@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// ------- 地图格子类型 -------
+//
+// 所有“这个字符是什么地形”的判断都查这里的编译期表，
+// 不再在各处写 == '.' / == '#'。新增地形只需要在 build_tile_table 里加一行。
+
+constexpr char TILE_WALL  = '#';
+constexpr char TILE_FLOOR = '.';
+constexpr char TILE_DOOR  = '+';
+constexpr char TILE_WATER = '~';
+
+struct TileRgb {
+    std::uint8_t r, g, b;
+};
+
+struct TileTraits {
+    bool walkable;             // 能否走上去
+    bool opaque;               // 是否挡视线
+    char glyph;                // 控制台显示字符
+    const char* consoleColor;  // 控制台 ANSI 颜色
+    TileRgb litColor;          // 图形前端：在视野内
+    TileRgb darkColor;         // 图形前端：探索过但不在视野内
+    int moveCost;              // 走进这一格的代价（不可走为 0）
+};
+
+namespace tile_detail {
+
+// 表里没有登记的字符：当作不可走、挡视线
+constexpr TileTraits UNKNOWN_TILE = {
+    false, true, '?', "\x1b[37m", { 100, 100, 100 }, { 60, 60, 60 }, 0
+};
+
+constexpr std::array<TileTraits, 256> build_tile_table() {
+    std::array<TileTraits, 256> t{};
+    for (std::size_t i = 0; i < t.size(); ++i) t[i] = UNKNOWN_TILE;
+
+    //                                          walk   opaque glyph       console     lit               dark            cost
+    t[static_cast<unsigned char>(TILE_WALL)]  = { false, true,  TILE_WALL,  "\x1b[37m", { 130, 130, 130 }, { 40, 40, 40 }, 0 };
+    t[static_cast<unsigned char>(TILE_FLOOR)] = { true,  false, TILE_FLOOR, "\x1b[90m", {  60,  60,  60 }, { 30, 30, 30 }, 1 };
+    t[static_cast<unsigned char>(TILE_DOOR)]  = { true,  true,  TILE_DOOR,  "\x1b[33m", { 150, 100,  40 }, { 60, 40, 20 }, 1 };
+    t[static_cast<unsigned char>(TILE_WATER)] = { true,  false, TILE_WATER, "\x1b[34m", {  40,  70, 160 }, { 20, 30, 60 }, 3 };
+    return t;
+}
+
+// 热路径只需要的两个标志单独压成一个字节表，256 字节正好 4 条缓存行
+constexpr std::uint8_t FLAG_WALKABLE = 1u << 0;
+constexpr std::uint8_t FLAG_OPAQUE   = 1u << 1;
+
+constexpr std::array<std::uint8_t, 256> build_flag_table(const std::array<TileTraits, 256>& traits) {
+    std::array<std::uint8_t, 256> f{};
+    for (std::size_t i = 0; i < f.size(); ++i) {
+        f[i] = static_cast<std::uint8_t>((traits[i].walkable ? FLAG_WALKABLE : 0) |
+                                         (traits[i].opaque   ? FLAG_OPAQUE   : 0));
+    }
+    return f;
+}
+
+inline constexpr std::array<TileTraits, 256>   TILE_TABLE = build_tile_table();
+inline constexpr std::array<std::uint8_t, 256> FLAG_TABLE = build_flag_table(TILE_TABLE);
+
+} // namespace tile_detail
+
+constexpr const TileTraits& tile_traits(char tile) {
+    return tile_detail::TILE_TABLE[static_cast<unsigned char>(tile)];
+}
+
+constexpr bool tile_walkable(char tile) {
+    return (tile_detail::FLAG_TABLE[static_cast<unsigned char>(tile)] & tile_detail::FLAG_WALKABLE) != 0;
+}
+
+constexpr bool tile_opaque(char tile) {
+    return (tile_detail::FLAG_TABLE[static_cast<unsigned char>(tile)] & tile_detail::FLAG_OPAQUE) != 0;
+}
+
+constexpr int tile_move_cost(char tile) {
+    return tile_traits(tile).moveCost;
+}
+
+// 编译期已知字符时直接用常量，例如 tile_walkable_v<TILE_FLOOR>
+template <char Tile>
+inline constexpr bool tile_walkable_v = tile_walkable(Tile);
+
+template <char Tile>
+inline constexpr bool tile_opaque_v = tile_opaque(Tile);
+
+static_assert(tile_walkable_v<TILE_FLOOR> && !tile_opaque_v<TILE_FLOOR>, "floor must be walkable");
+static_assert(!tile_walkable_v<TILE_WALL> && tile_opaque_v<TILE_WALL>, "wall must block");
@@ -0,0 +1,27 @@
+#pragma once
+
+// 复制时不跟着复制的缓存：拷贝构造 / 拷贝赋值得到的都是默认构造的 T，
+// 移动时照常移动。
+// 用来放每回合都会重建的临时数据（预约表、距离场缓冲区、渲染索引等），
+// 这样推测执行复制 Game 快照时只复制真正的游戏状态。
+// 里面的类型必须能从默认状态自己懒重建。
+template <typename T>
+class TransientCache {
+public:
+    TransientCache() = default;
+    TransientCache(const TransientCache&) {}
+    TransientCache(TransientCache&&) = default;
+    TransientCache& operator=(const TransientCache&) {
+        value = T();
+        return *this;
+    }
+    TransientCache& operator=(TransientCache&&) = default;
+
+    T& operator*() { return value; }
+    const T& operator*() const { return value; }
+    T* operator->() { return &value; }
+    const T* operator->() const { return &value; }
+
+private:
+    T value;
+};
@@ -0,0 +1,112 @@
+#include "viewport.hpp"
+#include <algorithm>
+#include <cmath>
+
+Viewport::Viewport(int viewWidth, int viewHeight, int tileSize)
+    : viewWidth(viewWidth), viewHeight(viewHeight), tileSize(std::max(1, tileSize)) {
+}
+
+void Viewport::setViewport(int w, int h) {
+    viewWidth = std::max(0, w);
+    viewHeight = std::max(0, h);
+}
+
+void Viewport::setZoom(float zoom) {
+    zoomLevel = std::min(MAX_ZOOM, std::max(MIN_ZOOM, zoom));
+}
+
+int Viewport::tilePixels() const {
+    return std::max(1, static_cast<int>(std::lround(tileSize * zoomLevel)));
+}
+
+int Viewport::columns() const {
+    int tp = tilePixels();
+    return (viewWidth + tp - 1) / tp;
+}
+
+int Viewport::rows() const {
+    int tp = tilePixels();
+    return (viewHeight + tp - 1) / tp;
+}
+
+// 一个轴上的视口起点：目标居中，贴住地图两端；地图放不满视口时整体居中
+static int clamp_origin(int target, int view, int mapSize) {
+    if (mapSize <= view) return (mapSize - view) / 2;
+    int origin = target - view / 2;
+    return std::min(std::max(origin, 0), mapSize - view);
+}
+
+void Viewport::follow(int tx, int ty, int mapW, int mapH) {
+    mapWidth = mapW;
+    mapHeight = mapH;
+    originX = clamp_origin(tx, columns(), mapWidth);
+    originY = clamp_origin(ty, rows(), mapHeight);
+}
+
+TileRect Viewport::visibleTiles() const {
+    TileRect r;
+    r.x0 = std::max(originX, 0);
+    r.y0 = std::max(originY, 0);
+    r.x1 = std::min(originX + columns(), mapWidth);
+    r.y1 = std::min(originY + rows(), mapHeight);
+    return r;
+}
+
+void EntityChunkIndex::rebuild(const std::vector<Entity>& entities, int width, int height) {
+    mapWidth = width;
+    mapHeight = height;
+    int cx = (mapWidth + CHUNK - 1) / CHUNK;
+    int cy = (mapHeight + CHUNK - 1) / CHUNK;
+    if (cx != chunksX || cy != chunksY) {
+        chunksX = cx;
+        chunksY = cy;
+        chunks.assign(static_cast<std::size_t>(cx) * cy, {});
+    } else {
+        for (auto& c : chunks) c.clear();   // 保留容量，下次重建不用再分配
+    }
+
+    for (std::size_t i = 0; i < entities.size(); ++i) {
+        int c = chunkOf(entities[i].x, entities[i].y);
+        if (c != -1) chunks[c].push_back(i);
+    }
+    dirty = false;
+}
+
+void EntityChunkIndex::onEntityMoved(std::size_t i, int oldX, int oldY, int newX, int newY) {
+    if (dirty) return;   // 反正下次查询要整体重建
+
+    int from = chunkOf(oldX, oldY);
+    int to   = chunkOf(newX, newY);
+    if (from == to) return;
+
+    if (from != -1) {
+        std::vector<std::size_t>& bucket = chunks[from];
+        auto it = std::find(bucket.begin(), bucket.end(), i);
+        if (it != bucket.end()) {
+            *it = bucket.back();
+            bucket.pop_back();
+        }
+    }
+    if (to != -1) chunks[to].push_back(i);
+}
+
+void EntityChunkIndex::query(const std::vector<Entity>& entities, int width, int height,
+                             const TileRect& rect, std::vector<std::size_t>& out) {
+    out.clear();
+    if (dirty) rebuild(entities, width, height);
+    if (rect.empty()) return;
+
+    int bx0 = std::max(rect.x0, 0) / CHUNK;
+    int by0 = std::max(rect.y0, 0) / CHUNK;
+    int bx1 = std::min((rect.x1 - 1) / CHUNK, chunksX - 1);
+    int by1 = std::min((rect.y1 - 1) / CHUNK, chunksY - 1);
+
+    for (int by = by0; by <= by1; ++by) {
+        for (int bx = bx0; bx <= bx1; ++bx) {
+            for (std::size_t i : chunks[by * chunksX + bx]) {
+                if (rect.contains(entities[i].x, entities[i].y)) out.push_back(i);
+            }
+        }
+    }
+    std::sort(out.begin(), out.end());
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "entity.hpp"
+
+// 地图上的一块矩形区域（格子坐标，左闭右开）
+struct TileRect {
+    int x0 = 0, y0 = 0;
+    int x1 = 0, y1 = 0;
+
+    bool contains(int x, int y) const {
+        return x >= x0 && x < x1 && y >= y0 && y < y1;
+    }
+    bool empty() const { return x0 >= x1 || y0 >= y1; }
+};
+
+// 视口（相机）：两个前端共用。视口大小用屏幕单位（raylib 为像素，命令行为字符），
+// 一个格子在缩放 1 时占 tileSize 个单位。相机跟随目标居中，贴住地图边缘；
+// 地图比视口小时地图居中显示。
+// 前端只需要遍历 visibleTiles() 里的格子，绘制开销只和屏幕大小有关。
+class Viewport {
+public:
+    Viewport(int viewWidth, int viewHeight, int tileSize);
+
+    void setViewport(int viewWidth, int viewHeight);
+    void setZoom(float zoom);            // 限制在 [MIN_ZOOM, MAX_ZOOM]
+    void zoomBy(float factor) { setZoom(zoomLevel * factor); }
+    float zoom() const { return zoomLevel; }
+
+    // 当前缩放下一个格子占多少屏幕单位（至少 1）
+    int tilePixels() const;
+    // 视口能放下多少列 / 行格子（最后一列 / 行可能只露出一部分）
+    int columns() const;
+    int rows() const;
+
+    // 以 (tx, ty) 为中心，按地图大小夹住视口
+    void follow(int tx, int ty, int mapWidth, int mapHeight);
+
+    // 视口内、且在地图范围内的格子
+    TileRect visibleTiles() const;
+
+    // 格子左上角在屏幕上的位置
+    int screenX(int tileX) const { return (tileX - originX) * tilePixels(); }
+    int screenY(int tileY) const { return (tileY - originY) * tilePixels(); }
+
+    static constexpr float MIN_ZOOM = 0.25f;
+    static constexpr float MAX_ZOOM = 4.0f;
+
+private:
+    int viewWidth;
+    int viewHeight;
+    int tileSize;
+    float zoomLevel = 1.0f;
+
+    int originX = 0;    // 视口左上角对应的格子（可以为负：地图比视口小时居中）
+    int originY = 0;
+    int mapWidth = 0;
+    int mapHeight = 0;
+};
+
+// 按块划分的实体索引：每个 CHUNK × CHUNK 的块记录落在里面的实体下标，
+// 查询一个矩形只看和它相交的块。
+// 实体移动时只把它从旧块挪到新块，O(块内实体数)；
+// 增删实体会让下标整体变化，这时标记脏，下一次查询时整体重建。
+class EntityChunkIndex {
+public:
+    static constexpr int CHUNK = 16;
+
+    // 增删实体（或者换了地图）之后调用
+    void markDirty() { dirty = true; }
+
+    // 第 i 个实体从 (oldX, oldY) 移动到了 (newX, newY)
+    void onEntityMoved(std::size_t i, int oldX, int oldY, int newX, int newY);
+
+    // 矩形内的实体下标，按下标升序（和 entities 里的顺序一致）
+    void query(const std::vector<Entity>& entities, int width, int height,
+               const TileRect& rect, std::vector<std::size_t>& out);
+
+private:
+    bool dirty = true;
+    int chunksX = 0;
+    int chunksY = 0;
+    int mapWidth = 0;
+    int mapHeight = 0;
+    std::vector<std::vector<std::size_t>> chunks;
+
+    int chunkOf(int x, int y) const {
+        if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight) return -1;
+        return (y / CHUNK) * chunksX + x / CHUNK;
+    }
+
+    void rebuild(const std::vector<Entity>& entities, int width, int height);
+};
@@ -0,0 +1,82 @@
+#include "visibility.hpp"
+#include "tile.hpp"
+#include <cstdlib>
+
+// 少于这么多条查询时分块并行不划算
+static const std::size_t PARALLEL_MIN_QUERIES = 256;
+static const std::size_t QUERIES_PER_TASK     = 128;
+
+void VisibilityEngine::setOpaque(int x, int y, bool v) {
+    std::size_t idx = static_cast<std::size_t>(y) * width + x;
+    std::uint64_t bit = 1ull << (idx & 63);
+    if (v) bits[idx >> 6] |= bit;
+    else   bits[idx >> 6] &= ~bit;
+}
+
+void VisibilityEngine::build(const std::vector<std::string>& map) {
+    height = static_cast<int>(map.size());
+    width  = height > 0 ? static_cast<int>(map[0].size()) : 0;
+    bits.assign((static_cast<std::size_t>(width) * height + 63) / 64, 0);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (tile_opaque(map[y][x])) setOpaque(x, y, true);
+        }
+    }
+}
+
+void VisibilityEngine::onTileChanged(const std::vector<std::string>& map, int x, int y) {
+    if (x < 0 || x >= width || y < 0 || y >= height) return;
+    setOpaque(x, y, tile_opaque(map[y][x]));
+}
+
+bool VisibilityEngine::lineOfSight(int x0, int y0, int x1, int y1, int maxRange) const {
+    if (x0 < 0 || x0 >= width || y0 < 0 || y0 >= height) return false;
+    if (x1 < 0 || x1 >= width || y1 < 0 || y1 >= height) return false;
+
+    int dx = std::abs(x1 - x0);
+    int dy = std::abs(y1 - y0);
+    if (dx * dx + dy * dy > maxRange * maxRange) return false;
+
+    // Bresenham，和 game.cpp 里 FoV 用的走法一致，但不生成中间数组
+    int sx = (x0 < x1) ? 1 : -1;
+    int sy = (y0 < y1) ? 1 : -1;
+    int err = dx - dy;
+
+    int x = x0;
+    int y = y0;
+    while (x != x1 || y != y1) {
+        // 起点不检查，终点之前的遮挡格会挡住视线
+        if ((x != x0 || y != y0) && opaque(x, y)) return false;
+
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+    return true;
+}
+
+void VisibilityEngine::batchLineOfSight(const std::vector<LosQuery>& queries, int maxRange,
+                                        std::vector<char>& results,
+                                        WorkStealingPool* pool) const {
+    results.assign(queries.size(), 0);
+
+    auto body = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const LosQuery& q = queries[i];
+            results[i] = lineOfSight(q.x0, q.y0, q.x1, q.y1, maxRange) ? 1 : 0;
+        }
+    };
+
+    if (pool && queries.size() >= PARALLEL_MIN_QUERIES) {
+        pool->parallel_for(queries.size(), QUERIES_PER_TASK, body);
+    } else {
+        body(0, queries.size());
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "work_stealing_pool.hpp"
+
+// 一次视线查询：观察者 (x0, y0) 能否看到 (x1, y1)
+struct LosQuery {
+    int x0, y0;
+    int x1, y1;
+};
+
+// 批量视线引擎：所有观察者共用一张按位压缩的遮挡图，
+// 每条视线沿 Bresenham 直线逐格检查，遇到第一个遮挡格立刻返回。
+// 规则与 Game::updateFov 相同：起点不挡视线，遮挡格本身可见，它后面的格子不可见。
+class VisibilityEngine {
+public:
+    VisibilityEngine() = default;
+
+    void build(const std::vector<std::string>& map);
+    // map[y][x] 已经改成新地形之后调用
+    void onTileChanged(const std::vector<std::string>& map, int x, int y);
+
+    bool opaque(int x, int y) const {
+        std::size_t idx = static_cast<std::size_t>(y) * width + x;
+        return (bits[idx >> 6] >> (idx & 63)) & 1u;
+    }
+
+    // 超出 maxRange（欧氏距离）直接判为看不见，不走直线
+    bool lineOfSight(int x0, int y0, int x1, int y1, int maxRange) const;
+
+    // results[i] 为第 i 个查询是否可见。
+    // 给了线程池并且查询足够多时按观察者分块并行，否则在当前线程顺序计算
+    void batchLineOfSight(const std::vector<LosQuery>& queries, int maxRange,
+                          std::vector<char>& results,
+                          WorkStealingPool* pool = nullptr) const;
+
+private:
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint64_t> bits; // 1 = 挡视线
+
+    void setOpaque(int x, int y, bool v);
+};
@@ -0,0 +1,148 @@
+#include "work_stealing_pool.hpp"
+#include <algorithm>
+
+// 记录当前线程属于哪个池、是第几个工作线程
+static thread_local const WorkStealingPool* tlsPool = nullptr;
+static thread_local int tlsWorkerIndex = -1;
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount) {
+    if (threadCount == 0) threadCount = 1;
+
+    for (unsigned i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    // 队列要在任何线程启动前全部建好，工作线程只读 queues
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait_idle();
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeCv.notify_all();
+    for (auto& t : workers) {
+        t.join();
+    }
+}
+
+int WorkStealingPool::currentWorker() const {
+    return tlsPool == this ? tlsWorkerIndex : -1;
+}
+
+void WorkStealingPool::submit(Task task) {
+    int self = currentWorker();
+    unsigned target = self >= 0
+        ? static_cast<unsigned>(self)
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+
+    pending.fetch_add(1);
+    {
+        // 先加计数再放进队列，两步都在队列锁里：任务一被别的线程看到，
+        // 计数就已经算上它了，popTask 的 fetch_sub 不会减到 0 以下。
+        // 计数同时在 sleepMutex 下增加，保证等待中的线程不会错过唤醒
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        {
+            std::lock_guard<std::mutex> sleepLock(sleepMutex);
+            queued.fetch_add(1);
+        }
+        queues[target]->tasks.push_front(std::move(task));
+    }
+    wakeCv.notify_one();
+}
+
+bool WorkStealingPool::popTask(int self, Task& out) {
+    unsigned n = size();
+
+    if (self >= 0) {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            out = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // 从别人的队尾偷
+    unsigned start = self >= 0 ? static_cast<unsigned>(self) + 1 : 0;
+    for (unsigned k = 0; k < n; ++k) {
+        Queue& victim = *queues[(start + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            out = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::runTask(Task& task) {
+    task();
+    if (pending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        idleCv.notify_all();
+    }
+}
+
+void WorkStealingPool::workerLoop(unsigned index) {
+    tlsPool = this;
+    tlsWorkerIndex = static_cast<int>(index);
+
+    while (true) {
+        Task task;
+        if (popTask(static_cast<int>(index), task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCv.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
+
+void WorkStealingPool::parallel_for(std::size_t count, std::size_t grain,
+                                    const std::function<void(std::size_t, std::size_t)>& body) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+
+    std::size_t chunks = (count + grain - 1) / grain;
+    if (chunks == 1) {
+        body(0, count);
+        return;
+    }
+
+    std::atomic<std::size_t> remaining{chunks};
+    for (std::size_t c = 0; c < chunks; ++c) {
+        std::size_t begin = c * grain;
+        std::size_t end   = std::min(count, begin + grain);
+        submit([&body, &remaining, begin, end] {
+            body(begin, end);
+            remaining.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    // 调用线程一起干活，直到自己提交的块都做完
+    int self = currentWorker();
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        Task task;
+        if (popTask(self, task)) {
+            runTask(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void WorkStealingPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    idleCv.wait(lock, [this] { return pending.load() == 0; });
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+
+// 工作窃取线程池：
+// - 每个工作线程有自己的任务队列，从队头取（后进先出，缓存友好）
+// - 自己的队列空了就去别的线程的队尾“偷”任务
+// - 外部线程提交的任务轮流放进各个队列
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(unsigned threadCount = std::thread::hardware_concurrency());
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    void submit(Task task);
+
+    // 把 [0, count) 切成大小为 grain 的块并行执行 body(begin, end)。
+    // 调用线程不会干等，而是一起执行任务，直到所有块完成；
+    // 所以在池子自己的工作线程里调用也不会死锁。
+    void parallel_for(std::size_t count, std::size_t grain,
+                      const std::function<void(std::size_t, std::size_t)>& body);
+
+    // 等待所有已提交的任务执行完
+    void wait_idle();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::atomic<std::size_t> queued{0};   // 还在队列里的任务
+    std::atomic<std::size_t> pending{0};  // 已提交但还没执行完的任务
+    std::atomic<unsigned> nextQueue{0};
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeCv;
+    std::condition_variable idleCv;
+    bool stopping = false;
+
+    void workerLoop(unsigned index);
+    int currentWorker() const;            // 当前线程在本池中的编号，外部线程为 -1
+    bool popTask(int self, Task& out);    // 先取自己的队列，再去偷别人的
+    void runTask(Task& task);
+};